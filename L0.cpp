@@ -1,9 +1,38 @@
 #include <iostream>
 #include <cmath>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include <memory>
 #include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <termios.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <csignal>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define L0_HAVE_X86_SIMD 1
+#endif
+
+#ifdef L0_USE_LIBJPEG
+#include <csetjmp>
+#include <jpeglib.h>
+#endif
 
 #define STBI_NO_GIF
 #define STB_IMAGE_IMPLEMENTATION
@@ -13,8 +42,33 @@ using std::cout;
 using std::endl;
 using std::string;
 using std::min;
+using std::vector;
 
 const string DEFAULT_COLOR = "\033[0m";
+const size_t MAX_CELL_BYTES = 48;
+const int HEADER_ROWS = 2;
+const char UPPER_HALF_BLOCK[] = "\xE2\x96\x80";
+
+const int KEY_ESCAPE = 27;
+const int KEY_ARROW_LEFT = 1000;
+const int KEY_ARROW_RIGHT = 1001;
+
+enum class ColorMode {
+    TrueColor,
+    Palette256,
+    Palette16
+};
+
+// ԪɫɫֱӴ 0xRRGGBBɫģʽڸֽڴǡֽڴɫ±
+const uint32_t PALETTE_256_TAG = 0x01000000;
+const uint32_t PALETTE_16_TAG = 0x02000000;
+
+struct ViewerOptions {
+    bool halfBlock = false;
+    ColorMode colorMode = ColorMode::TrueColor;
+    bool dither = false;
+    int prefetchCount = 2;
+};
 
 struct TerminalSize {
     int columns;
@@ -27,95 +81,1301 @@ TerminalSize getTerminalDimensions() {
     return { window.ws_col, window.ws_row };
 }
 
-string formatColorValue(int value) {
-    string result = std::to_string(value);
-    while (result.length() < 3) {
-        result = "0" + result;
+struct ImageLevel {
+    int width = 0;
+    int height = 0;
+    vector<unsigned char> pixels;
+};
+
+// нԴأ߽߰ƽۼӵĿռڴֻĿй
+class StreamingDownsampler {
+public:
+    StreamingDownsampler(int sourceWidth, int sourceHeight, ImageLevel& target)
+        : target(target), sourceWidth(sourceWidth), sourceHeight(sourceHeight),
+        columnStart(target.width + 1), rowSums((size_t)target.width * 3) {
+        target.pixels.assign((size_t)target.width * target.height * 3, 0);
+        for (int col = 0; col <= target.width; ++col) {
+            columnStart[col] = (int)((long long)col * sourceWidth / target.width);
+        }
+    }
+
+    void pushRow(const unsigned char* row) {
+        if (targetRow >= target.height) {
+            return;
+        }
+        for (int col = 0; col < target.width; ++col) {
+            uint32_t* sums = &rowSums[(size_t)col * 3];
+            for (int x = columnStart[col]; x < columnStart[col + 1]; ++x) {
+                sums[0] += row[x * 3];
+                sums[1] += row[x * 3 + 1];
+                sums[2] += row[x * 3 + 2];
+            }
+        }
+        ++sourceRow;
+        ++accumulatedRows;
+
+        if (sourceRow == (int)((long long)(targetRow + 1) * sourceHeight / target.height)) {
+            unsigned char* out = &target.pixels[(size_t)targetRow * target.width * 3];
+            for (int col = 0; col < target.width; ++col) {
+                uint32_t count = (uint32_t)(accumulatedRows * (columnStart[col + 1] - columnStart[col]));
+                for (int c = 0; c < 3; ++c) {
+                    out[col * 3 + c] = (unsigned char)((rowSums[(size_t)col * 3 + c] + count / 2) / count);
+                }
+            }
+            std::fill(rowSums.begin(), rowSums.end(), 0);
+            accumulatedRows = 0;
+            ++targetRow;
+        }
+    }
+
+private:
+    ImageLevel& target;
+    int sourceWidth;
+    int sourceHeight;
+    vector<int> columnStart;
+    vector<uint32_t> rowSums;
+    int sourceRow = 0;
+    int targetRow = 0;
+    int accumulatedRows = 0;
+};
+
+// ԭͼߴȱ limit x limit ĿڣСͼԭߴ
+void fitWithin(int width, int height, int limit, int& fittedWidth, int& fittedHeight) {
+    if (width <= limit && height <= limit) {
+        fittedWidth = width;
+        fittedHeight = height;
+        return;
     }
-    return result;
+    double scale = min((double)limit / width, (double)limit / height);
+    fittedWidth = std::max(1, (int)(width * scale));
+    fittedHeight = std::max(1, (int)(height * scale));
 }
 
-void displayImage(const string& imagePath) {
-    bool exitRequested = false;
+#ifdef L0_USE_LIBJPEG
+struct JpegErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jumpBuffer;
+};
 
-    while (!exitRequested) {
-        TerminalSize terminal = getTerminalDimensions();
+void onJpegError(j_common_ptr info) {
+    longjmp(((JpegErrorManager*)info->err)->jumpBuffer, 1);
+}
 
-        int imgWidth, imgHeight, colorChannels;
-        unsigned char* pixelData = stbi_load(imagePath.c_str(), &imgWidth, &imgHeight, &colorChannels, 3);
-        if (pixelData == nullptr) {
-            cout << "ͼƬʧ: " << imagePath << endl;
-            return;
+//  JPEG  DCT ֱӽ 1/21/41/8 ߴ磬ɨۼӵĿ񣬲ȫߴ绺
+bool decodeJpegDownsampled(const string& path, int limit, ImageLevel& base, int& originalWidth, int& originalHeight) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    jpeg_decompress_struct info;
+    JpegErrorManager error;
+    info.err = jpeg_std_error(&error.base);
+    error.base.error_exit = onJpegError;
+    vector<unsigned char> scanline;
+    std::unique_ptr<StreamingDownsampler> downsampler;
+    if (setjmp(error.jumpBuffer)) {
+        jpeg_destroy_decompress(&info);
+        fclose(file);
+        return false;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_stdio_src(&info, file);
+    jpeg_read_header(&info, TRUE);
+    originalWidth = (int)info.image_width;
+    originalHeight = (int)info.image_height;
+    fitWithin(originalWidth, originalHeight, limit, base.width, base.height);
+
+    info.out_color_space = JCS_RGB;
+    info.scale_num = 1;
+    for (unsigned int denominator = 8; denominator >= 1; denominator /= 2) {
+        info.scale_denom = denominator;
+        jpeg_calc_output_dimensions(&info);
+        if ((int)info.output_width >= base.width && (int)info.output_height >= base.height) {
+            break;
         }
+    }
 
-        float scalingFactor = min((float)terminal.columns / imgWidth,
-            (float)(terminal.rows - 3) / imgHeight);
-        int outputWidth = (int)(imgWidth * scalingFactor);
-        int outputHeight = (int)(imgHeight * scalingFactor);
+    jpeg_start_decompress(&info);
+    scanline.resize((size_t)info.output_width * 3);
+    downsampler.reset(new StreamingDownsampler((int)info.output_width, (int)info.output_height, base));
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = scanline.data();
+        jpeg_read_scanlines(&info, &row, 1);
+        downsampler->pushRow(scanline.data());
+    }
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    fclose(file);
+    return true;
+}
 
-        system("clear");
+bool isJpegFile(const string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    unsigned char magic[2] = { 0, 0 };
+    size_t count = fread(magic, 1, 2, file);
+    fclose(file);
+    return count == 2 && magic[0] == 0xFF && magic[1] == 0xD8;
+}
+#endif
 
-        cout << "ͼߴ: ԭʼ " << imgWidth << "x" << imgHeight
-            << ", ź " << outputWidth << "x" << outputHeight << "" << endl;
-        cout << "ESC˳ı䴰ڴСʱԶˢ..." << endl;
+// һκפڴ棺0Ϊԭͼͼ MAX_BASE_SIZE ڣÿ㳤룬
+// ڱ仯ʱֻӺʵĲ²
+class ImageCache {
+public:
+    static constexpr int MAX_LEVELS = 6;
+    static constexpr int MIN_LEVEL_SIZE = 32;
+    static constexpr int MAX_BASE_SIZE = 2048;
 
-        for (int row = 0; row < outputHeight; ++row) {
-            for (int col = 0; col < outputWidth; ++col) {
-                int sourceX = min((int)(col / scalingFactor), imgWidth - 1);
-                int sourceY = min((int)(row / scalingFactor), imgHeight - 1);
+    bool load(const string& path) {
+        levels.clear();
+        ImageLevel base;
+        if (!decodeBase(path, base)) {
+            return false;
+        }
+        levels.push_back(std::move(base));
+
+        while ((int)levels.size() < MAX_LEVELS &&
+            levels.back().width / 2 >= MIN_LEVEL_SIZE &&
+            levels.back().height / 2 >= MIN_LEVEL_SIZE) {
+            levels.push_back(halve(levels.back()));
+        }
+        return true;
+    }
 
-                int pixelIndex = (sourceY * imgWidth + sourceX) * 3;
-                int red = pixelData[pixelIndex];
-                int green = pixelData[pixelIndex + 1];
-                int blue = pixelData[pixelIndex + 2];
+    int width() const { return originalWidth; }
+    int height() const { return originalHeight; }
+    size_t levelCount() const { return levels.size(); }
 
-                string colorCode = "\033[48;2;" + formatColorValue(red) + ";" +
-                    formatColorValue(green) + ";" +
-                    formatColorValue(blue) + "m";
-                cout << colorCode << "  " << DEFAULT_COLOR;
+    // ѡСĿߴСһ㣬ֻ֤СŴ
+    const ImageLevel& selectLevel(int targetWidth, int targetHeight) const {
+        size_t chosen = 0;
+        for (size_t i = 1; i < levels.size(); ++i) {
+            if (levels[i].width < targetWidth || levels[i].height < targetHeight) {
+                break;
             }
-            cout << endl;
+            chosen = i;
         }
+        return levels[chosen];
+    }
 
+private:
+    vector<ImageLevel> levels;
+    int originalWidth = 0;
+    int originalHeight = 0;
+
+    bool decodeBase(const string& path, ImageLevel& base) {
+#ifdef L0_USE_LIBJPEG
+        if (isJpegFile(path)) {
+            return decodeJpegDownsampled(path, MAX_BASE_SIZE, base, originalWidth, originalHeight);
+        }
+#endif
+        int colorChannels;
+        unsigned char* pixelData = stbi_load(path.c_str(), &originalWidth, &originalHeight, &colorChannels, 3);
+        if (pixelData == nullptr) {
+            return false;
+        }
+
+        fitWithin(originalWidth, originalHeight, MAX_BASE_SIZE, base.width, base.height);
+        if (base.width == originalWidth && base.height == originalHeight) {
+            base.pixels.assign(pixelData, pixelData + (size_t)originalWidth * originalHeight * 3);
+        } else {
+            StreamingDownsampler downsampler(originalWidth, originalHeight, base);
+            for (int y = 0; y < originalHeight; ++y) {
+                downsampler.pushRow(pixelData + (size_t)y * originalWidth * 3);
+            }
+        }
         stbi_image_free(pixelData);
+        return true;
+    }
 
-        while (true) {
-            TerminalSize currentTerminal = getTerminalDimensions();
-            if (currentTerminal.columns != terminal.columns ||
-                currentTerminal.rows != terminal.rows) {
-                break;
+    static ImageLevel halve(const ImageLevel& source) {
+        ImageLevel result;
+        result.width = source.width / 2;
+        result.height = source.height / 2;
+        result.pixels.resize((size_t)result.width * result.height * 3);
+
+        size_t sourceStride = (size_t)source.width * 3;
+        for (int y = 0; y < result.height; ++y) {
+            const unsigned char* top = &source.pixels[(size_t)(y * 2) * sourceStride];
+            const unsigned char* bottom = top + sourceStride;
+            unsigned char* out = &result.pixels[(size_t)y * result.width * 3];
+            for (int x = 0; x < result.width; ++x) {
+                for (int c = 0; c < 3; ++c) {
+                    int sum = top[x * 6 + c] + top[x * 6 + 3 + c] +
+                        bottom[x * 6 + c] + bottom[x * 6 + 3 + c];
+                    out[x * 3 + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        return result;
+    }
+};
+
+void scaleNearest(const ImageLevel& source, int outputWidth, int outputHeight, vector<uint32_t>& cells) {
+    cells.resize((size_t)outputWidth * outputHeight);
+    for (int row = 0; row < outputHeight; ++row) {
+        const unsigned char* sourceRow = &source.pixels[
+            (size_t)min(row * source.height / outputHeight, source.height - 1) * source.width * 3];
+        for (int col = 0; col < outputWidth; ++col) {
+            int sourceX = min(col * source.width / outputWidth, source.width - 1);
+            const unsigned char* pixel = sourceRow + (size_t)sourceX * 3;
+            cells[(size_t)row * outputWidth + col] = ((uint32_t)pixel[0] << 16) | ((uint32_t)pixel[1] << 8) | pixel[2];
+        }
+    }
+}
+
+typedef void (*RowAccumulator)(uint32_t* sums, const unsigned char* row, size_t count);
+
+void accumulateRowScalar(uint32_t* sums, const unsigned char* row, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        sums[i] += row[i];
+    }
+}
+
+#ifdef L0_HAVE_X86_SIMD
+__attribute__((target("sse2")))
+void accumulateRowSse2(uint32_t* sums, const unsigned char* row, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(row + i));
+        __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        __m128i high = _mm_unpackhi_epi8(bytes, zero);
+        __m128i* target = (__m128i*)(sums + i);
+        _mm_storeu_si128(target, _mm_add_epi32(_mm_loadu_si128(target), _mm_unpacklo_epi16(low, zero)));
+        _mm_storeu_si128(target + 1, _mm_add_epi32(_mm_loadu_si128(target + 1), _mm_unpackhi_epi16(low, zero)));
+        _mm_storeu_si128(target + 2, _mm_add_epi32(_mm_loadu_si128(target + 2), _mm_unpacklo_epi16(high, zero)));
+        _mm_storeu_si128(target + 3, _mm_add_epi32(_mm_loadu_si128(target + 3), _mm_unpackhi_epi16(high, zero)));
+    }
+    accumulateRowScalar(sums + i, row + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void accumulateRowAvx2(uint32_t* sums, const unsigned char* row, size_t count) {
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        for (int part = 0; part < 4; ++part) {
+            __m256i widened = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(row + i + part * 8)));
+            __m256i* target = (__m256i*)(sums + i + part * 8);
+            _mm256_storeu_si256(target, _mm256_add_epi32(_mm256_loadu_si256(target), widened));
+        }
+    }
+    accumulateRowScalar(sums + i, row + i, count - i);
+}
+#endif
+
+struct RowAccumulatorChoice {
+    const char* name;
+    RowAccumulator function;
+};
+
+RowAccumulatorChoice selectRowAccumulator() {
+#ifdef L0_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return { "AVX2", accumulateRowAvx2 };
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return { "SSE2", accumulateRowSse2 };
+    }
+#endif
+    return { "scalar", accumulateRowScalar };
+}
+
+const RowAccumulatorChoice ROW_ACCUMULATOR = selectRowAccumulator();
+
+// ƽţȰиǵԴۼӵкͣSIMDٶÿ񸲸ǵȡƽ
+void scaleArea(const ImageLevel& source, int outputWidth, int outputHeight, vector<uint32_t>& cells,
+    RowAccumulator accumulate = ROW_ACCUMULATOR.function) {
+    cells.resize((size_t)outputWidth * outputHeight);
+    if (outputWidth <= 0 || outputHeight <= 0) {
+        return;
+    }
+    size_t rowBytes = (size_t)source.width * 3;
+    vector<uint32_t> columnSums(rowBytes);
+
+    vector<int> columnStart(outputWidth + 1);
+    for (int col = 0; col <= outputWidth; ++col) {
+        columnStart[col] = (int)((long long)col * source.width / outputWidth);
+    }
+
+    for (int row = 0; row < outputHeight; ++row) {
+        int firstRow = (int)((long long)row * source.height / outputHeight);
+        int lastRow = std::max(firstRow + 1, (int)((long long)(row + 1) * source.height / outputHeight));
+        std::fill(columnSums.begin(), columnSums.end(), 0);
+        for (int y = firstRow; y < lastRow; ++y) {
+            accumulate(columnSums.data(), &source.pixels[(size_t)y * rowBytes], rowBytes);
+        }
+
+        int rowCount = lastRow - firstRow;
+        for (int col = 0; col < outputWidth; ++col) {
+            int firstColumn = columnStart[col];
+            int lastColumn = std::max(firstColumn + 1, columnStart[col + 1]);
+            uint32_t red = 0, green = 0, blue = 0;
+            for (int x = firstColumn; x < lastColumn; ++x) {
+                red += columnSums[x * 3];
+                green += columnSums[x * 3 + 1];
+                blue += columnSums[x * 3 + 2];
+            }
+            uint32_t count = (uint32_t)(rowCount * (lastColumn - firstColumn));
+            uint32_t half = count / 2;
+            cells[(size_t)row * outputWidth + col] = (((red + half) / count) << 16) |
+                (((green + half) / count) << 8) | ((blue + half) / count);
+        }
+    }
+}
+
+struct DecimalTable {
+    char text[256][4];
+    unsigned char length[256];
+
+    DecimalTable() {
+        for (int value = 0; value < 256; ++value) {
+            string digits = std::to_string(value);
+            memcpy(text[value], digits.c_str(), digits.length());
+            length[value] = (unsigned char)digits.length();
+        }
+    }
+};
+
+const DecimalTable DECIMALS;
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct FrameStats {
+    size_t bytes = 0;
+    size_t changedCells = 0;
+    double renderMilliseconds = 0;
+    double scaleMilliseconds = 0;       // šɸ
+    double encodeMilliseconds = 0;      // ƴװת
+};
+
+// ֡ƴһԤĻһ write 
+class FrameBuilder {
+public:
+    void begin(size_t expectedBytes) {
+        if (buffer.size() < expectedBytes) {
+            buffer.resize(expectedBytes);
+        }
+        length = 0;
+    }
+
+    void append(const char* data, size_t count) {
+        reserve(count);
+        memcpy(&buffer[length], data, count);
+        length += count;
+    }
+
+    void append(const string& text) {
+        append(text.data(), text.length());
+    }
+
+    void append(char value) {
+        reserve(1);
+        buffer[length++] = value;
+    }
+
+    void appendDecimal(unsigned char value) {
+        append(DECIMALS.text[value], DECIMALS.length[value]);
+    }
+
+    void appendNumber(int value) {
+        if (value >= 0 && value < 256) {
+            appendDecimal((unsigned char)value);
+        } else {
+            append(std::to_string(value));
+        }
+    }
+
+    void appendBackground(uint32_t color) {
+        appendColor(color, "\033[48;2;", "\033[48;5;", 40, 100);
+    }
+
+    void appendForeground(uint32_t color) {
+        appendColor(color, "\033[38;2;", "\033[38;5;", 30, 90);
+    }
+
+    void appendCursor(int row, int column) {
+        append("\033[", 2);
+        appendNumber(row);
+        append(';');
+        appendNumber(column);
+        append('H');
+    }
+
+    size_t size() const { return length; }
+    const char* data() const { return buffer.data(); }
+
+    bool flush(int fd) {
+        size_t written = 0;
+        while (written < length) {
+            ssize_t result = write(fd, buffer.data() + written, length - written);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            written += (size_t)result;
+        }
+        return true;
+    }
+
+private:
+    vector<char> buffer;
+    size_t length = 0;
+
+    void appendColor(uint32_t color, const char* trueColorPrefix, const char* palettePrefix,
+        int basicBase, int brightBase) {
+        if (color & PALETTE_16_TAG) {
+            int index = color & 0xFF;
+            append("\033[", 2);
+            appendDecimal((unsigned char)(index < 8 ? basicBase + index : brightBase + index - 8));
+            append('m');
+        } else if (color & PALETTE_256_TAG) {
+            append(palettePrefix, 7);
+            appendDecimal((unsigned char)color);
+            append('m');
+        } else {
+            append(trueColorPrefix, 7);
+            appendDecimal((unsigned char)(color >> 16));
+            append(';');
+            appendDecimal((unsigned char)(color >> 8));
+            append(';');
+            appendDecimal((unsigned char)color);
+            append('m');
+        }
+    }
+
+    void reserve(size_t count) {
+        if (length + count > buffer.size()) {
+            buffer.resize((length + count) * 2);
+        }
+    }
+};
+
+// RGB ȡ 5 λ 32x32x32 ĲұÿԤĵɫɫ
+class PaletteTable {
+public:
+    explicit PaletteTable(ColorMode mode) {
+        vector<uint32_t> palette;
+        int firstIndex = 0;
+        if (mode == ColorMode::Palette16) {
+            palette = {
+                0x000000, 0xCD0000, 0x00CD00, 0xCDCD00, 0x0000EE, 0xCD00CD, 0x00CDCD, 0xE5E5E5,
+                0x7F7F7F, 0xFF0000, 0x00FF00, 0xFFFF00, 0x5C5CFF, 0xFF00FF, 0x00FFFF, 0xFFFFFF
+            };
+            tag = PALETTE_16_TAG;
+            ditherSpread = 96;
+        } else {
+            // 0-15 ɫն仯ֻʹ 6x6x6 ɫ 24 ҽ
+            const int levels[6] = { 0, 95, 135, 175, 215, 255 };
+            firstIndex = 16;
+            for (int red = 0; red < 6; ++red) {
+                for (int green = 0; green < 6; ++green) {
+                    for (int blue = 0; blue < 6; ++blue) {
+                        palette.push_back(((uint32_t)levels[red] << 16) | ((uint32_t)levels[green] << 8) | levels[blue]);
+                    }
+                }
+            }
+            for (int gray = 0; gray < 24; ++gray) {
+                uint32_t level = 8 + gray * 10;
+                palette.push_back((level << 16) | (level << 8) | level);
             }
+            tag = PALETTE_256_TAG;
+            ditherSpread = 40;
+        }
 
-            struct termios originalSettings, modifiedSettings;
-            tcgetattr(STDIN_FILENO, &originalSettings);
-            modifiedSettings = originalSettings;
-            modifiedSettings.c_lflag &= ~(ICANON | ECHO);
-            modifiedSettings.c_cc[VMIN] = 0;
-            modifiedSettings.c_cc[VTIME] = 0;
-            tcsetattr(STDIN_FILENO, TCSANOW, &modifiedSettings);
+        for (int red = 0; red < 32; ++red) {
+            for (int green = 0; green < 32; ++green) {
+                for (int blue = 0; blue < 32; ++blue) {
+                    int centerRed = red * 8 + 4;
+                    int centerGreen = green * 8 + 4;
+                    int centerBlue = blue * 8 + 4;
+                    int bestIndex = 0;
+                    int bestDistance = 1 << 30;
+                    for (size_t i = 0; i < palette.size(); ++i) {
+                        int deltaRed = centerRed - (int)(palette[i] >> 16);
+                        int deltaGreen = centerGreen - (int)((palette[i] >> 8) & 0xFF);
+                        int deltaBlue = centerBlue - (int)(palette[i] & 0xFF);
+                        int distance = 2 * deltaRed * deltaRed + 4 * deltaGreen * deltaGreen + 3 * deltaBlue * deltaBlue;
+                        if (distance < bestDistance) {
+                            bestDistance = distance;
+                            bestIndex = (int)i + firstIndex;
+                        }
+                    }
+                    table[(red << 10) | (green << 5) | blue] = (unsigned char)bestIndex;
+                }
+            }
+        }
+    }
 
-            char inputChar;
-            if (read(STDIN_FILENO, &inputChar, 1) > 0) {
-                if (inputChar == 27) {
-                    exitRequested = true;
-                    break;
+    uint32_t lookup(int red, int green, int blue) const {
+        return tag | table[((red >> 3) << 10) | ((green >> 3) << 5) | (blue >> 3)];
+    }
+
+    // 4x4 Bayer 򶶶λüһ̶ƫٲ
+    void quantize(vector<uint32_t>& pixels, int width, int height, bool dither) const {
+        static const int bayer[4][4] = {
+            { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 }
+        };
+        for (int y = 0; y < height; ++y) {
+            uint32_t* row = &pixels[(size_t)y * width];
+            for (int x = 0; x < width; ++x) {
+                int red = (int)(row[x] >> 16);
+                int green = (int)((row[x] >> 8) & 0xFF);
+                int blue = (int)(row[x] & 0xFF);
+                if (dither) {
+                    int offset = (bayer[y & 3][x & 3] * 2 - 15) * ditherSpread / 32;
+                    red = std::clamp(red + offset, 0, 255);
+                    green = std::clamp(green + offset, 0, 255);
+                    blue = std::clamp(blue + offset, 0, 255);
                 }
+                row[x] = lookup(red, green, blue);
             }
+        }
+    }
+
+private:
+    unsigned char table[32 * 32 * 32];
+    uint32_t tag = 0;
+    int ditherSpread = 0;
+};
 
+// һնַͨģʽֻñɫո񣻰ģʽϰַ U+2580ǰΪϰأΪ°
+struct Cell {
+    uint32_t background = 0;
+    uint32_t foreground = 0;
+
+    bool operator==(const Cell& other) const {
+        return background == other.background && foreground == other.foreground;
+    }
+};
+
+void buildCells(const vector<uint32_t>& pixels, int pixelWidth, int pixelHeight, bool halfBlock,
+    vector<Cell>& cells) {
+    if (!halfBlock) {
+        cells.resize(pixels.size());
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            cells[i].background = pixels[i];
+            cells[i].foreground = pixels[i];
+        }
+        return;
+    }
+
+    int cellRows = pixelHeight / 2;
+    cells.resize((size_t)pixelWidth * cellRows);
+    for (int row = 0; row < cellRows; ++row) {
+        const uint32_t* top = &pixels[(size_t)(row * 2) * pixelWidth];
+        const uint32_t* bottom = top + pixelWidth;
+        Cell* out = &cells[(size_t)row * pixelWidth];
+        for (int col = 0; col < pixelWidth; ++col) {
+            out[col].foreground = top[col];
+            out[col].background = bottom[col];
+        }
+    }
+}
+
+// סһ֡ĵԪֻػɫ仯ĸӣͬɫӲظɫ
+class CellRenderer {
+public:
+    void invalidate() {
+        previousCells.clear();
+    }
+
+    bool needsFullRepaint(int width, int height) const {
+        return previousCells.empty() || width != previousWidth || height != previousHeight;
+    }
+
+    size_t render(FrameBuilder& frame, const vector<Cell>& cells, int width, int height, int originRow,
+        bool halfBlock) {
+        bool fullRepaint = needsFullRepaint(width, height);
+        int cellColumns = halfBlock ? 1 : 2;
+        bool backgroundActive = false;
+        bool foregroundActive = false;
+        uint32_t currentBackground = 0;
+        uint32_t currentForeground = 0;
+        size_t changedCells = 0;
+
+        for (int row = 0; row < height; ++row) {
+            int cursorColumn = -1;
+            for (int col = 0; col < width; ++col) {
+                size_t index = (size_t)row * width + col;
+                const Cell& cell = cells[index];
+                if (!fullRepaint && previousCells[index] == cell) {
+                    continue;
+                }
+                if (cursorColumn != col) {
+                    frame.appendCursor(originRow + row, col * cellColumns + 1);
+                }
+                if (!backgroundActive || currentBackground != cell.background) {
+                    frame.appendBackground(cell.background);
+                    currentBackground = cell.background;
+                    backgroundActive = true;
+                }
+                if (!halfBlock) {
+                    frame.append("  ", 2);
+                } else if (cell.foreground == cell.background) {
+                    frame.append(' ');
+                } else {
+                    if (!foregroundActive || currentForeground != cell.foreground) {
+                        frame.appendForeground(cell.foreground);
+                        currentForeground = cell.foreground;
+                        foregroundActive = true;
+                    }
+                    frame.append(UPPER_HALF_BLOCK, 3);
+                }
+                cursorColumn = col + 1;
+                ++changedCells;
+            }
+        }
+        if (backgroundActive) {
+            frame.append(DEFAULT_COLOR);
+        }
+
+        previousCells = cells;
+        previousWidth = width;
+        previousHeight = height;
+        return changedCells;
+    }
+
+private:
+    vector<Cell> previousCells;
+    int previousWidth = 0;
+    int previousHeight = 0;
+};
+
+// ̨̳߳أǰҪͼƬ嵽ףԤȡͼƬڶβ
+class DecodePool {
+public:
+    explicit DecodePool(int workerCount) {
+        for (int i = 0; i < workerCount; ++i) {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~DecodePool() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+            jobs.clear();
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void submit(std::function<void()> job, bool urgent) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (urgent) {
+                jobs.push_front(std::move(job));
+            } else {
+                jobs.push_back(std::move(job));
+            }
+        }
+        wake.notify_one();
+    }
+
+private:
+    vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex queueMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+// ͼƬбֻڽ̷߳ʣǰͼƬǰһŵ prefetchCount ŵĽ
+class ImageLibrary {
+public:
+    ImageLibrary(const vector<string>& paths, int prefetchCount)
+        : paths(paths), slots(paths.size()), prefetchCount(prefetchCount),
+        pool(std::max(1, min(prefetchCount, (int)std::thread::hardware_concurrency()))) {}
+
+    size_t size() const { return paths.size(); }
+    const string& path(size_t index) const { return paths[index]; }
+
+    std::shared_ptr<ImageCache> get(size_t index) {
+        request(index, true);
+        return slots[index].get();
+    }
+
+    void prefetchAround(size_t index) {
+        long long first = (long long)index - 1;
+        long long last = (long long)index + prefetchCount;
+        for (long long i = (long long)index + 1; i <= last && i < (long long)paths.size(); ++i) {
+            request((size_t)i, false);
+        }
+        if (first >= 0) {
+            request((size_t)first, false);
+        }
+        for (long long i = 0; i < (long long)slots.size(); ++i) {
+            if (i < first || i > last) {
+                slots[i] = DecodedImage();
+            }
+        }
+    }
+
+private:
+    typedef std::shared_future<std::shared_ptr<ImageCache>> DecodedImage;
+
+    vector<string> paths;
+    vector<DecodedImage> slots;
+    int prefetchCount;
+    DecodePool pool;
+
+    void request(size_t index, bool urgent) {
+        if (slots[index].valid()) {
+            return;
+        }
+        string imagePath = paths[index];
+        auto task = std::make_shared<std::packaged_task<std::shared_ptr<ImageCache>()>>([imagePath]() {
+            auto image = std::make_shared<ImageCache>();
+            if (!image->load(imagePath)) {
+                image.reset();
+            }
+            return image;
+        });
+        slots[index] = task->get_future().share();
+        pool.submit([task]() { (*task)(); }, urgent);
+    }
+};
+
+bool isImageFile(const std::filesystem::path& path) {
+    static const vector<string> extensions = {
+        ".jpg", ".jpeg", ".png", ".bmp", ".tga", ".psd", ".hdr", ".pic", ".pnm", ".ppm", ".pgm"
+    };
+    string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return (char)std::tolower(c); });
+    return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+}
+
+// Ŀ¼չΪеͼƬļļ򣩣ͨ·ԭ
+vector<string> collectImagePaths(const vector<string>& arguments) {
+    vector<string> paths;
+    for (const string& argument : arguments) {
+        std::error_code error;
+        if (!std::filesystem::is_directory(argument, error)) {
+            paths.push_back(argument);
+            continue;
+        }
+        vector<string> directoryImages;
+        for (const auto& entry : std::filesystem::directory_iterator(argument, error)) {
+            if (entry.is_regular_file(error) && isImageFile(entry.path())) {
+                directoryImages.push_back(entry.path().string());
+            }
+        }
+        std::sort(directoryImages.begin(), directoryImages.end());
+        paths.insert(paths.end(), directoryImages.begin(), directoryImages.end());
+    }
+    return paths;
+}
+
+enum class ViewerEvent {
+    Resize,
+    Key,
+    Quit
+};
+
+// SIGWINCH/SIGINT/SIGTERM ֻԹܵдһֽڣѭ poll ͬʱȴźţʱռ CPU
+class TerminalSession {
+public:
+    TerminalSession() {
+        active = tcgetattr(STDIN_FILENO, &originalSettings) == 0;
+        if (active) {
+            struct termios rawSettings = originalSettings;
+            rawSettings.c_lflag &= ~(ICANON | ECHO);
+            rawSettings.c_cc[VMIN] = 1;
+            rawSettings.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSANOW, &rawSettings);
+        }
+
+        if (pipe(signalPipe) == 0) {
+            for (int fd : signalPipe) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+        }
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = onSignal;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGWINCH, &action, &previousWinch);
+        sigaction(SIGINT, &action, &previousInt);
+        sigaction(SIGTERM, &action, &previousTerm);
+    }
+
+    ~TerminalSession() {
+        sigaction(SIGWINCH, &previousWinch, nullptr);
+        sigaction(SIGINT, &previousInt, nullptr);
+        sigaction(SIGTERM, &previousTerm, nullptr);
+        close(signalPipe[0]);
+        close(signalPipe[1]);
+        signalPipe[0] = signalPipe[1] = -1;
+
+        if (active) {
             tcsetattr(STDIN_FILENO, TCSANOW, &originalSettings);
         }
+        const char restore[] = "\033[0m\n";
+        write(STDOUT_FILENO, restore, sizeof(restore) - 1);
+    }
+
+    TerminalSession(const TerminalSession&) = delete;
+    TerminalSession& operator=(const TerminalSession&) = delete;
+
+    ViewerEvent waitForEvent(int& key) {
+        struct pollfd watched[2];
+        watched[0] = { STDIN_FILENO, POLLIN, 0 };
+        watched[1] = { signalPipe[0], POLLIN, 0 };
+
+        while (true) {
+            if (poll(watched, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return ViewerEvent::Quit;
+            }
+
+            if (watched[1].revents & POLLIN) {
+                bool resized = false;
+                bool quit = false;
+                char signalByte;
+                while (read(signalPipe[0], &signalByte, 1) > 0) {
+                    resized |= signalByte == 'w';
+                    quit |= signalByte == 'q';
+                }
+                if (quit) {
+                    return ViewerEvent::Quit;
+                }
+                if (resized) {
+                    return ViewerEvent::Resize;
+                }
+            }
+
+            if (watched[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+                unsigned char input;
+                if (read(STDIN_FILENO, &input, 1) <= 0) {
+                    return ViewerEvent::Quit;
+                }
+                key = input == KEY_ESCAPE ? readEscapeSequence() : input;
+                return ViewerEvent::Key;
+            }
+        }
+    }
+
+private:
+    static int signalPipe[2];
+    struct termios originalSettings;
+
+    //  ESC [ C / ESC [ D ESC ʱڲкֽ
+    static int readEscapeSequence() {
+        struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+        unsigned char sequence[2];
+        if (poll(&input, 1, 30) <= 0 || read(STDIN_FILENO, &sequence[0], 1) <= 0 || sequence[0] != '[') {
+            return KEY_ESCAPE;
+        }
+        if (poll(&input, 1, 30) <= 0 || read(STDIN_FILENO, &sequence[1], 1) <= 0) {
+            return KEY_ESCAPE;
+        }
+        if (sequence[1] == 'C') {
+            return KEY_ARROW_RIGHT;
+        }
+        if (sequence[1] == 'D') {
+            return KEY_ARROW_LEFT;
+        }
+        return 0;
+    }
+
+    bool active = false;
+    struct sigaction previousWinch, previousInt, previousTerm;
+
+    static void onSignal(int signalNumber) {
+        int savedErrno = errno;
+        char signalByte = signalNumber == SIGWINCH ? 'w' : 'q';
+        if (signalPipe[1] >= 0) {
+            write(signalPipe[1], &signalByte, 1);
+        }
+        errno = savedErrno;
     }
+};
+
+int TerminalSession::signalPipe[2] = { -1, -1 };
+
+struct FrameLayout {
+    int outputWidth = 0;
+    int outputHeight = 0;
+    int cellRows = 0;
+};
+
+// ͨģʽÿռһУģʽÿռһаУ߶Ρ
+// ģʽÿҪǰͱɫնʱÿֽ֡ԼΪͨģʽ 4 
+// ˰ͨģʽַͬԷֱΪͨģʽ 2 ֽԼ 2 
+FrameLayout computeLayout(TerminalSize terminal, int imgWidth, int imgHeight, bool halfBlock) {
+    int availableWidth = terminal.columns / 2;
+    int availableHeight = terminal.rows - 3;
+    float scalingFactor = min((float)availableWidth / imgWidth, (float)availableHeight / imgHeight);
+    if (halfBlock) {
+        float fullDensityFactor = min((float)terminal.columns / imgWidth, (float)availableHeight * 2 / imgHeight);
+        scalingFactor = min(fullDensityFactor, scalingFactor * std::sqrt(2.0f));
+    }
+
+    FrameLayout layout;
+    layout.outputWidth = (int)(imgWidth * scalingFactor);
+    layout.outputHeight = (int)(imgHeight * scalingFactor);
+    if (halfBlock) {
+        layout.outputHeight &= ~1;
+    }
+    layout.cellRows = halfBlock ? layout.outputHeight / 2 : layout.outputHeight;
+    return layout;
+}
+
+// һ֡ͼֽڵ̣ʾն˲Թã֤Եľʵʷ֡
+class FramePipeline {
+public:
+    explicit FramePipeline(const ViewerOptions& viewerOptions) : options(viewerOptions) {
+        if (options.colorMode != ColorMode::TrueColor) {
+            palette.reset(new PaletteTable(options.colorMode));
+        }
+    }
+
+    void invalidate() {
+        renderer.invalidate();
+    }
+
+    // šɸӣٰͷкͱ仯ĸӱ output()ɵ÷д
+    // image ΪձʾǰͼƬʧܣֻͷ
+    FrameStats build(const ImageCache* image, const FrameLayout& layout, const string& position,
+        const string& imagePath, bool slideshow) {
+        FrameStats stats;
+        auto stageStart = std::chrono::steady_clock::now();
+        if (image) {
+            scaleArea(image->selectLevel(layout.outputWidth, layout.outputHeight),
+                layout.outputWidth, layout.outputHeight, pixels);
+        }
+        if (palette) {
+            palette->quantize(pixels, layout.outputWidth, layout.outputHeight, options.dither);
+        }
+        buildCells(pixels, layout.outputWidth, layout.outputHeight, options.halfBlock, cells);
+        stats.scaleMilliseconds = millisecondsSince(stageStart);
+
+        stageStart = std::chrono::steady_clock::now();
+        frame.begin((size_t)layout.outputWidth * layout.cellRows * MAX_CELL_BYTES + 512);
+        if (renderer.needsFullRepaint(layout.outputWidth, layout.cellRows)) {
+            frame.append("\033[2J", 4);
+        }
+        frame.append("\033[H\033[K", 6);
+        if (image) {
+            frame.append(position + "ͼߴ: ԭʼ " + std::to_string(image->width()) + "x" +
+                std::to_string(image->height()) + ", ź " + std::to_string(layout.outputWidth) + "x" +
+                std::to_string(layout.outputHeight) + "\n\033[K");
+        } else {
+            frame.append(position + "ͼƬʧ: " + imagePath + "\n\033[K");
+        }
+        frame.append(slideshow ?
+            "ESC˳n/ һţp/ һţı䴰ڴСʱԶˢ...\n" :
+            "ESC˳ı䴰ڴСʱԶˢ...\n");
+        stats.changedCells = renderer.render(frame, cells, layout.outputWidth, layout.cellRows, HEADER_ROWS + 1,
+            options.halfBlock);
+        stats.encodeMilliseconds = millisecondsSince(stageStart);
+        stats.bytes = frame.size();
+        return stats;
+    }
+
+    FrameBuilder& output() {
+        return frame;
+    }
+
+private:
+    const ViewerOptions& options;
+    std::unique_ptr<PaletteTable> palette;
+    FrameBuilder frame;
+    CellRenderer renderer;
+    vector<uint32_t> pixels;
+    vector<Cell> cells;
+};
+
+void displayImages(ImageLibrary& library, const ViewerOptions& options) {
+    size_t currentIndex = 0;
+    auto decodeStart = std::chrono::steady_clock::now();
+    std::shared_ptr<ImageCache> image = library.get(currentIndex);
+    double decodeWaitMilliseconds = millisecondsSince(decodeStart);
+    if (image == nullptr && library.size() == 1) {
+        cout << "ͼƬʧ: " << library.path(0) << endl;
+        return;
+    }
+    library.prefetchAround(currentIndex);
+
+    TerminalSession session;
+    FramePipeline pipeline(options);
+    TerminalSize lastTerminal = { 0, 0 };
+    bool exitRequested = false;
+
+    while (!exitRequested) {
+        TerminalSize terminal = getTerminalDimensions();
+        int imgWidth = image ? image->width() : 1;
+        int imgHeight = image ? image->height() : 1;
+
+        FrameLayout layout = image ? computeLayout(terminal, imgWidth, imgHeight, options.halfBlock) : FrameLayout();
+
+        if (terminal.columns != lastTerminal.columns || terminal.rows != lastTerminal.rows) {
+            pipeline.invalidate();
+            lastTerminal = terminal;
+        }
+
+        auto renderStart = std::chrono::steady_clock::now();
+        string position = library.size() > 1 ?
+            "[" + std::to_string(currentIndex + 1) + "/" + std::to_string(library.size()) + "] " : "";
+        FrameStats stats = pipeline.build(image.get(), layout, position, library.path(currentIndex),
+            library.size() > 1);
+        pipeline.output().flush(STDOUT_FILENO);
+        stats.renderMilliseconds = millisecondsSince(renderStart);
+
+        string statusLine = "\033[" + std::to_string(HEADER_ROWS + layout.cellRows + 1) + ";1H\033[J" +
+            "֡ " + std::to_string(stats.bytes) + " ֽڣ " + std::to_string(stats.changedCells) +
+            " Ⱦʱ " + std::to_string(stats.renderMilliseconds) + " ms";
+        if (library.size() > 1) {
+            statusLine += "ȴ " + std::to_string(decodeWaitMilliseconds) + " ms";
+        }
+        write(STDOUT_FILENO, statusLine.data(), statusLine.length());
+
+        while (true) {
+            int key = 0;
+            ViewerEvent event = session.waitForEvent(key);
+            if (event == ViewerEvent::Quit || (event == ViewerEvent::Key && (key == KEY_ESCAPE || key == 'q'))) {
+                exitRequested = true;
+                break;
+            }
+            if (event == ViewerEvent::Resize) {
+                break;
+            }
+
+            size_t nextIndex = currentIndex;
+            if ((key == 'n' || key == ' ' || key == KEY_ARROW_RIGHT) && currentIndex + 1 < library.size()) {
+                nextIndex = currentIndex + 1;
+            } else if ((key == 'p' || key == KEY_ARROW_LEFT) && currentIndex > 0) {
+                nextIndex = currentIndex - 1;
+            }
+            if (nextIndex != currentIndex) {
+                currentIndex = nextIndex;
+                decodeStart = std::chrono::steady_clock::now();
+                image = library.get(currentIndex);
+                decodeWaitMilliseconds = millisecondsSince(decodeStart);
+                library.prefetchAround(currentIndex);
+                break;
+            }
+        }
+    }
+}
+
+// ն˵ȾԣָͬһͼȾ N ֡дļֱͳƽ롢šдʱ
+int benchmarkHeadless(const string& imagePath, TerminalSize terminal, int frameCount,
+    const string& outputPath, const ViewerOptions& options) {
+    auto decodeStart = std::chrono::steady_clock::now();
+    ImageCache image;
+    if (!image.load(imagePath)) {
+        cout << "ͼƬʧ: " << imagePath << endl;
+        return 1;
+    }
+    double decodeMilliseconds = millisecondsSince(decodeStart);
+
+    int outputFile = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (outputFile < 0) {
+        cout << "޷ļ: " << outputPath << endl;
+        return 1;
+    }
+
+    FrameLayout layout = computeLayout(terminal, image.width(), image.height(), options.halfBlock);
+    FramePipeline pipeline(options);
+    double scaleMilliseconds = 0;
+    double encodeMilliseconds = 0;
+    double writeMilliseconds = 0;
+    size_t totalBytes = 0;
+
+    // ÿ֡ػ棬
+    for (int i = 0; i < frameCount; ++i) {
+        pipeline.invalidate();
+        FrameStats stats = pipeline.build(&image, layout, "", imagePath, false);
+        scaleMilliseconds += stats.scaleMilliseconds;
+        encodeMilliseconds += stats.encodeMilliseconds;
+
+        auto stageStart = std::chrono::steady_clock::now();
+        pipeline.output().flush(outputFile);
+        writeMilliseconds += millisecondsSince(stageStart);
+        totalBytes += stats.bytes;
+    }
+    close(outputFile);
+
+    cout << "նȾ: " << imagePath << "ն " << terminal.columns << "x" << terminal.rows
+        << " " << layout.outputWidth << "x" << layout.outputHeight << " أ" << frameCount << " ֡" << endl;
+    cout << ": " << decodeMilliseconds << " msһΣ" << endl;
+    cout << ": " << scaleMilliseconds / frameCount << " ms/֡" << endl;
+    cout << ": " << encodeMilliseconds / frameCount << " ms/֡" << endl;
+    cout << "д: " << writeMilliseconds / frameCount << " ms/֡" << endl;
+    cout << ": " << totalBytes / frameCount << " ֽ/֡" << endl;
+    return 0;
+}
+
+void benchmarkScalers(const string& imagePath) {
+    ImageLevel source;
+    ImageCache image;
+    if (!imagePath.empty() && image.load(imagePath)) {
+        source = image.selectLevel(image.width(), image.height());
+    } else {
+        source.width = 8192;
+        source.height = 6144;
+        source.pixels.resize((size_t)source.width * source.height * 3);
+        for (size_t i = 0; i < source.pixels.size(); ++i) {
+            source.pixels[i] = (unsigned char)((i * 2654435761u) >> 24);
+        }
+    }
+
+    const int outputWidth = 300;
+    const int outputHeight = 100;
+    const int iterations = 10;
+    cout << "Ų: Դͼ " << source.width << "x" << source.height
+        << " -> " << outputWidth << "x" << outputHeight << "ÿ " << iterations << " " << endl;
+
+    struct Candidate {
+        string name;
+        RowAccumulator accumulate;
+    };
+    vector<Candidate> candidates = { { "ƽ(scalar)", accumulateRowScalar } };
+#ifdef L0_HAVE_X86_SIMD
+    if (__builtin_cpu_supports("sse2")) {
+        candidates.push_back({ "ƽ(SSE2)", accumulateRowSse2 });
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        candidates.push_back({ "ƽ(AVX2)", accumulateRowAvx2 });
+    }
+#endif
+
+    vector<uint32_t> cells;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        scaleNearest(source, outputWidth, outputHeight, cells);
+    }
+    cout << "ڲ: " << millisecondsSince(start) / iterations << " ms/֡" << endl;
+
+    vector<uint32_t> reference;
+    scaleArea(source, outputWidth, outputHeight, reference, accumulateRowScalar);
+    for (const Candidate& candidate : candidates) {
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            scaleArea(source, outputWidth, outputHeight, cells, candidate.accumulate);
+        }
+        double elapsed = millisecondsSince(start) / iterations;
+        cout << candidate.name << ": " << elapsed << " ms/֡"
+            << (cells == reference ? "" : "ʵֲһ£") << endl;
+    }
+    cout << "ʱѡ: " << ROW_ACCUMULATOR.name << endl;
 }
 
 int main(int argCount, char* argValues[]) {
-    if (argCount != 2) {
+    ViewerOptions options;
+    vector<string> imageArguments;
+    bool benchScale = false;
+    bool headless = false;
+    TerminalSize headlessTerminal = { 0, 0 };
+    int headlessFrames = 100;
+    string headlessOutput = "/dev/null";
+    bool headlessOnlyOption = false;        // --frames--output ֻ --headless 
+    bool argumentsValid = true;
+
+    for (int i = 1; i < argCount; ++i) {
+        string argument = argValues[i];
+        if (argument == "--half") {
+            options.halfBlock = true;
+        } else if (argument == "--bench-scale") {
+            benchScale = true;
+        } else if (argument == "--colors" && i + 1 < argCount) {
+            string colors = argValues[++i];
+            if (colors == "256") {
+                options.colorMode = ColorMode::Palette256;
+            } else if (colors == "16") {
+                options.colorMode = ColorMode::Palette16;
+            } else if (colors == "true") {
+                options.colorMode = ColorMode::TrueColor;
+            } else {
+                argumentsValid = false;
+            }
+        } else if (argument == "--dither") {
+            options.dither = true;
+        } else if (argument == "--headless" && i + 1 < argCount) {
+            headless = sscanf(argValues[++i], "%dx%d", &headlessTerminal.columns, &headlessTerminal.rows) == 2 &&
+                headlessTerminal.columns > 1 && headlessTerminal.rows > 3;
+            argumentsValid = argumentsValid && headless;
+        } else if (argument == "--frames" && i + 1 < argCount) {
+            headlessFrames = std::max(1, atoi(argValues[++i]));
+            headlessOnlyOption = true;
+        } else if (argument == "--output" && i + 1 < argCount) {
+            headlessOutput = argValues[++i];
+            headlessOnlyOption = true;
+        } else if (argument == "--prefetch" && i + 1 < argCount) {
+            options.prefetchCount = std::max(1, atoi(argValues[++i]));
+        } else if (argument.rfind("--", 0) == 0) {
+            argumentsValid = false;
+        } else {
+            imageArguments.push_back(argument);
+        }
+    }
+
+    if (headlessOnlyOption && !headless) {
+        argumentsValid = false;
+    }
+
+    if (benchScale && argumentsValid && imageArguments.size() <= 1) {
+        benchmarkScalers(imageArguments.empty() ? "" : imageArguments[0]);
+        return 0;
+    }
+
+    if (headless && argumentsValid && imageArguments.size() == 1) {
+        return benchmarkHeadless(imageArguments[0], headlessTerminal, headlessFrames, headlessOutput, options);
+    }
+
+    vector<string> imagePaths = collectImagePaths(imageArguments);
+    if (!argumentsValid || imagePaths.empty()) {
         cout << "ʹ÷ȷ" << endl;
-        cout << "ȷʽ: " << argValues[0] << " <ͼļ·>" << endl;
+        cout << "ȷʽ: " << argValues[0] << " [--half] [--colors true|256|16] [--dither] [--prefetch N]"
+            << " <ͼļĿ¼·>..." << endl;
+        cout << "  --half        ַģʽÿַʾأַͨģʽͬ" << endl;
+        cout << "                ֱԼΪͨģʽ 1.4 ÿֽ֡ԼΪ 2 " << endl;
+        cout << "  --colors      ɫɫĬϣ256 ɫ 16 ɫ" << endl;
+        cout << "  --dither      256/16 ɫģʽʹ򶶶" << endl;
+        cout << "  --prefetch N  ͼƬʱ̨ԤȽ N ţĬ 2" << endl;
+        cout << "ܲ: " << argValues[0] << " --bench-scale [ͼļ·]" << endl;
+        cout << "նȾ: " << argValues[0]
+            << " --headless x [--frames N] [--output ļ] [ʾѡ] <ͼļ·>" << endl;
         return 1;
     }
 
-    string imageFilePath = argValues[1];
-    displayImage(imageFilePath);
+    ImageLibrary library(imagePaths, options.prefetchCount);
+    displayImages(library, options);
 
     return 0;
 }
\ No newline at end of file
@@ -1,12 +1,20 @@
 #include <iostream>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <vector>
 #include <random>
 #include <string>
 #include <chrono>
 #include <algorithm>
 #include <memory>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <atomic>
+#include <fstream>
+#include <queue>
+#include <cmath>
 
 using namespace std;
 
@@ -31,103 +39,1194 @@ struct MemoryBlock {
     }
 };
 
-// 简化的内存管理器
+// 分配后端类型，构造内存管理器时选择
+enum class AllocatorBackend {
+    ExtentIndex,    // 空闲区间索引，最佳适配
+    Buddy,          // 二的幂伙伴系统
+    LockFreeBitmap  // 固定粒度分块的原子位图，不加锁
+};
+
+// 空闲区间大小直方图：第 k 个桶统计大小在 [2^k, 2^(k+1)) 字节的空闲区间，最后一个桶收纳更大的
+constexpr int FREE_HISTOGRAM_BUCKETS = 28;
+
+int histogramBucket(long long size) {
+    return min(FREE_HISTOGRAM_BUCKETS - 1, 63 - __builtin_clzll(static_cast<unsigned long long>(size)));
+}
+
+// 按线程分片的计数器，每片独占一个缓存行，避免所有线程争用同一个计数
+constexpr int COUNTER_SHARDS = 16;
+
+struct alignas(64) PaddedCounter {
+    atomic<long long> value{0};
+};
+
+int threadShard() {
+    static atomic<int> nextShard{0};
+    thread_local int shard = nextShard.fetch_add(1, memory_order_relaxed) % COUNTER_SHARDS;
+    return shard;
+}
+
+long long sumShards(const PaddedCounter (&counters)[COUNTER_SHARDS]) {
+    long long total = 0;
+    for (const auto& counter : counters) {
+        total += counter.value.load(memory_order_relaxed);
+    }
+    return total;
+}
+
+// 分配策略接口：只负责在地址空间里找位置，加锁由内存管理器负责
+class AllocationPolicy {
+public:
+    virtual ~AllocationPolicy() = default;
+    virtual bool take(long long size, long long& start) = 0;
+    virtual void release(long long start, long long size) = 0;
+    virtual size_t extentCount() const = 0;         // 空闲区间（块）个数
+    virtual long long freeBytes() const = 0;        // 空闲字节总数
+    virtual long long largestFreeExtent() const = 0;
+    virtual void freeExtentHistogram(long long buckets[FREE_HISTOGRAM_BUCKETS]) const = 0;
+    virtual long long reservedSize(long long size) const { return size; }  // 实际占用的字节数
+    virtual bool lockFree() const { return false; }  // 为真时 take/release 可并发调用，内存管理器不加锁
+};
+
+// 空闲区间索引：按地址排序的 map 用于释放时合并相邻空闲区，
+// 按 (大小, 地址) 排序的 set 用于 O(log n) 的最佳适配查找（同样大小取地址最低的）
+class FreeExtentIndex : public AllocationPolicy {
+private:
+    map<long long, long long> byAddress;        // 起始地址 -> 大小
+    set<pair<long long, long long>> bySize;     // (大小, 起始地址)
+    long long totalFree = 0;
+    long long histogram[FREE_HISTOGRAM_BUCKETS] = {};
+
+    void insertExtent(long long start, long long size) {
+        byAddress.emplace(start, size);
+        bySize.emplace(size, start);
+        totalFree += size;
+        histogram[histogramBucket(size)]++;
+    }
+
+    void eraseExtent(map<long long, long long>::iterator it) {
+        totalFree -= it->second;
+        histogram[histogramBucket(it->second)]--;
+        bySize.erase({it->second, it->first});
+        byAddress.erase(it);
+    }
+
+public:
+    explicit FreeExtentIndex(long long totalSize) {
+        if (totalSize > 0) {
+            insertExtent(0, totalSize);
+        }
+    }
+
+    bool take(long long size, long long& start) override {
+        auto fit = bySize.lower_bound({size, 0});
+        if (fit == bySize.end()) {
+            return false;
+        }
+
+        long long extentSize = fit->first;
+        start = fit->second;
+        eraseExtent(byAddress.find(start));
+        if (extentSize > size) {
+            insertExtent(start + size, extentSize - size);
+        }
+        return true;
+    }
+
+    void release(long long start, long long size) override {
+        auto next = byAddress.lower_bound(start);
+        if (next != byAddress.begin()) {
+            auto previous = prev(next);
+            if (previous->first + previous->second == start) {
+                start = previous->first;
+                size += previous->second;
+                eraseExtent(previous);
+            }
+        }
+        if (next != byAddress.end() && start + size == next->first) {
+            size += next->second;
+            eraseExtent(next);
+        }
+        insertExtent(start, size);
+    }
+
+    size_t extentCount() const override {
+        return byAddress.size();
+    }
+
+    long long freeBytes() const override {
+        return totalFree;
+    }
+
+    long long largestFreeExtent() const override {
+        return bySize.empty() ? 0 : bySize.rbegin()->first;
+    }
+
+    void freeExtentHistogram(long long buckets[FREE_HISTOGRAM_BUCKETS]) const override {
+        copy(histogram, histogram + FREE_HISTOGRAM_BUCKETS, buckets);
+    }
+};
+
+// 多级位图：第 0 层每一位表示一个块，上一层每一位表示下一层对应的 64 位字是否非零，
+// 查找第一个置位只需从顶层逐层 ctz
+class LevelBitmap {
+private:
+    vector<vector<uint64_t>> levels;
+
+public:
+    explicit LevelBitmap(size_t bits) {
+        size_t words = max<size_t>(1, (bits + 63) / 64);
+        levels.emplace_back(words, 0);
+        while (words > 1) {
+            words = (words + 63) / 64;
+            levels.emplace_back(words, 0);
+        }
+    }
+
+    bool test(size_t index) const {
+        return (levels[0][index / 64] >> (index % 64)) & 1;
+    }
+
+    void set(size_t index) {
+        for (auto& level : levels) {
+            uint64_t& word = level[index / 64];
+            bool wasEmpty = word == 0;
+            word |= 1ULL << (index % 64);
+            if (!wasEmpty) break;
+            index /= 64;
+        }
+    }
+
+    void clear(size_t index) {
+        for (auto& level : levels) {
+            uint64_t& word = level[index / 64];
+            word &= ~(1ULL << (index % 64));
+            if (word != 0) break;
+            index /= 64;
+        }
+    }
+
+    long long findFirst() const {
+        if (levels.back()[0] == 0) {
+            return -1;
+        }
+        size_t index = 0;
+        for (size_t i = levels.size(); i-- > 0;) {
+            index = index * 64 + __builtin_ctzll(levels[i][index]);
+        }
+        return static_cast<long long>(index);
+    }
+};
+
+// 伙伴系统：每一阶一个多级位图记录空闲块，申请时从满足大小的最低阶向上找并逐级拆分，
+// 释放时与伙伴逐级合并，拆分与合并都是 O(阶数)
+class BuddyAllocator : public AllocationPolicy {
+private:
+    static constexpr int MIN_ORDER = 4;     // 最小块 16 字节
+    static constexpr int MAX_ORDER = 24;    // 最大块 16MB，等于 MAX_BLOCK_SIZE
+    long long totalMemory;
+    vector<LevelBitmap> freeBlocks;         // freeBlocks[k - MIN_ORDER] 的第 i 位表示起始地址 i << k 的块空闲
+    size_t freeBlockCount = 0;
+    long long totalFree = 0;
+    long long freeCountByOrder[MAX_ORDER + 1] = {};
+
+    static int orderOf(long long size) {
+        int order = MIN_ORDER;
+        while ((1LL << order) < size) {
+            order++;
+        }
+        return order;
+    }
+
+    void markFree(long long start, int order) {
+        freeBlocks[order - MIN_ORDER].set(static_cast<size_t>(start >> order));
+        freeBlockCount++;
+        freeCountByOrder[order]++;
+        totalFree += 1LL << order;
+    }
+
+    void markUsed(long long start, int order) {
+        freeBlocks[order - MIN_ORDER].clear(static_cast<size_t>(start >> order));
+        freeBlockCount--;
+        freeCountByOrder[order]--;
+        totalFree -= 1LL << order;
+    }
+
+    bool isFree(long long start, int order) const {
+        if (start + (1LL << order) > totalMemory) {
+            return false;
+        }
+        return freeBlocks[order - MIN_ORDER].test(static_cast<size_t>(start >> order));
+    }
+
+public:
+    explicit BuddyAllocator(long long size) : totalMemory(size) {
+        for (int order = MIN_ORDER; order <= MAX_ORDER; order++) {
+            freeBlocks.emplace_back(static_cast<size_t>((size >> order) + 1));
+        }
+        // 把整个区域切成尽量大的、按自身大小对齐的块
+        long long position = 0;
+        while (position + (1LL << MIN_ORDER) <= size) {
+            int order = MAX_ORDER;
+            while (order > MIN_ORDER &&
+                   (position % (1LL << order) != 0 || position + (1LL << order) > size)) {
+                order--;
+            }
+            markFree(position, order);
+            position += 1LL << order;
+        }
+    }
+
+    bool take(long long size, long long& start) override {
+        int order = orderOf(size);
+        if (order > MAX_ORDER) {
+            return false;
+        }
+        int found = order;
+        long long index = -1;
+        for (; found <= MAX_ORDER; found++) {
+            index = freeBlocks[found - MIN_ORDER].findFirst();
+            if (index >= 0) break;
+        }
+        if (index < 0) {
+            return false;
+        }
+
+        start = index << found;
+        markUsed(start, found);
+        while (found > order) {
+            found--;
+            markFree(start + (1LL << found), found);
+        }
+        return true;
+    }
+
+    void release(long long start, long long size) override {
+        int order = orderOf(size);
+        while (order < MAX_ORDER) {
+            long long buddy = start ^ (1LL << order);
+            if (!isFree(buddy, order)) break;
+            markUsed(buddy, order);
+            start = min(start, buddy);
+            order++;
+        }
+        markFree(start, order);
+    }
+
+    size_t extentCount() const override {
+        return freeBlockCount;
+    }
+
+    long long freeBytes() const override {
+        return totalFree;
+    }
+
+    long long largestFreeExtent() const override {
+        for (int order = MAX_ORDER; order >= MIN_ORDER; order--) {
+            if (freeCountByOrder[order] > 0) {
+                return 1LL << order;
+            }
+        }
+        return 0;
+    }
+
+    // 每一阶的空闲块大小正好是 2 的幂，直接对应一个桶
+    void freeExtentHistogram(long long buckets[FREE_HISTOGRAM_BUCKETS]) const override {
+        fill(buckets, buckets + FREE_HISTOGRAM_BUCKETS, 0);
+        for (int order = MIN_ORDER; order <= MAX_ORDER; order++) {
+            buckets[histogramBucket(1LL << order)] += freeCountByOrder[order];
+        }
+    }
+
+    long long reservedSize(long long size) const override {
+        return 1LL << orderOf(size);
+    }
+};
+
+// 无锁后端：整个区域按 CHUNK_SIZE 分块，每块一位记录在原子位图里。
+// 不超过 64 块的申请在单个字内找连续空位并用 CAS 置位；更大的申请按整字占用，逐字 CAS 0 -> 全 1，
+// 中途失败则回滚。每个线程从上次成功的位置开始找，减少线程之间在同一个字上的冲突。
+// 本类的方法可以被多个线程同时调用，内存管理器不会为它加锁
+class AtomicChunkBitmap : public AllocationPolicy {
+private:
+    static constexpr long long CHUNK_SIZE = 256;
+
+    size_t wordCount;
+    unique_ptr<atomic<uint64_t>[]> words;       // 置位表示已占用
+    PaddedCounter liveBlocks[COUNTER_SHARDS];
+
+    // 各线程的起始查找位置按分片错开
+    size_t& hintCursor() const {
+        thread_local size_t cursor = SIZE_MAX;
+        if (cursor == SIZE_MAX) {
+            cursor = wordCount * threadShard() / COUNTER_SHARDS;
+        }
+        return cursor;
+    }
+
+    static long long chunksFor(long long size) {
+        return (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    }
+
+    static uint64_t runMask(long long chunks, int position) {
+        return (chunks == 64 ? ~0ULL : ((1ULL << chunks) - 1)) << position;
+    }
+
+    // 返回 free 中长度不小于 chunks 的连续 1 的起点集合（倍增求交）
+    static uint64_t runStarts(uint64_t free, long long chunks) {
+        uint64_t runs = free;
+        long long length = 1;
+        while (length < chunks && runs != 0) {
+            long long shift = min(length, chunks - length);
+            runs &= runs >> shift;
+            length += shift;
+        }
+        return runs;
+    }
+
+    bool takeWithinWord(long long chunks, long long& start) {
+        size_t& hint = hintCursor();
+        for (size_t scanned = 0; scanned < wordCount; scanned++) {
+            size_t index = (hint + scanned) % wordCount;
+            uint64_t current = words[index].load(memory_order_relaxed);
+            while (true) {
+                uint64_t runs = runStarts(~current, chunks);
+                if (runs == 0) break;
+                int position = __builtin_ctzll(runs);
+                uint64_t mask = runMask(chunks, position);
+                if (words[index].compare_exchange_weak(current, current | mask,
+                                                       memory_order_acquire, memory_order_relaxed)) {
+                    hint = index;
+                    start = (static_cast<long long>(index) * 64 + position) * CHUNK_SIZE;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool takeWholeWords(size_t wordsNeeded, long long& start) {
+        size_t& hint = hintCursor();
+        size_t first = hint % wordCount;
+        for (size_t scanned = 0; scanned < wordCount; scanned++) {
+            size_t index = (first + scanned) % wordCount;
+            if (index + wordsNeeded > wordCount) continue;
+
+            size_t claimed = 0;
+            while (claimed < wordsNeeded) {
+                uint64_t expected = 0;
+                if (!words[index + claimed].compare_exchange_strong(expected, ~0ULL,
+                                                                   memory_order_acquire, memory_order_relaxed)) {
+                    break;
+                }
+                claimed++;
+            }
+            if (claimed == wordsNeeded) {
+                hint = index + wordsNeeded;
+                start = static_cast<long long>(index) * 64 * CHUNK_SIZE;
+                return true;
+            }
+            for (size_t i = 0; i < claimed; i++) {
+                words[index + i].store(0, memory_order_release);
+            }
+            scanned += claimed;
+        }
+        return false;
+    }
+
+public:
+    explicit AtomicChunkBitmap(long long size) {
+        long long chunkCount = size / CHUNK_SIZE;
+        wordCount = static_cast<size_t>((chunkCount + 63) / 64);
+        words.reset(new atomic<uint64_t>[wordCount]);
+        for (size_t i = 0; i < wordCount; i++) {
+            words[i].store(0, memory_order_relaxed);
+        }
+        // 最后一个字里超出区域的位永久标记为占用
+        long long tailBits = chunkCount % 64;
+        if (tailBits != 0) {
+            words[wordCount - 1].store(~0ULL << tailBits, memory_order_relaxed);
+        }
+    }
+
+    bool lockFree() const override {
+        return true;
+    }
+
+    bool take(long long size, long long& start) override {
+        long long chunks = chunksFor(size);
+        bool taken = chunks <= 64 ? takeWithinWord(chunks, start)
+                                  : takeWholeWords(static_cast<size_t>((chunks + 63) / 64), start);
+        if (taken) {
+            liveBlocks[threadShard()].value.fetch_add(1, memory_order_relaxed);
+        }
+        return taken;
+    }
+
+    void release(long long start, long long size) override {
+        long long chunks = chunksFor(size);
+        size_t index = static_cast<size_t>(start / CHUNK_SIZE / 64);
+        if (chunks <= 64) {
+            words[index].fetch_and(~runMask(chunks, static_cast<int>(start / CHUNK_SIZE % 64)),
+                                   memory_order_release);
+        } else {
+            for (long long i = 0; i < (chunks + 63) / 64; i++) {
+                words[index + i].store(0, memory_order_release);
+            }
+        }
+        liveBlocks[threadShard()].value.fetch_sub(1, memory_order_relaxed);
+    }
+
+    size_t liveBlockCount() const {
+        return static_cast<size_t>(max(0LL, sumShards(liveBlocks)));
+    }
+
+    // 以下统计逐字扫描位图，得到的是某一时刻附近的近似值
+    size_t extentCount() const override {
+        size_t runs = 0;
+        bool previousFree = false;
+        for (size_t i = 0; i < wordCount; i++) {
+            uint64_t free = ~words[i].load(memory_order_relaxed);
+            uint64_t starts = free & ~((free << 1) | (previousFree ? 1 : 0));
+            runs += __builtin_popcountll(starts);
+            previousFree = (free >> 63) & 1;
+        }
+        return runs;
+    }
+
+    long long freeBytes() const override {
+        long long freeChunks = 0;
+        for (size_t i = 0; i < wordCount; i++) {
+            freeChunks += 64 - __builtin_popcountll(words[i].load(memory_order_relaxed));
+        }
+        return freeChunks * CHUNK_SIZE;
+    }
+
+    long long largestFreeExtent() const override {
+        long long best = 0;
+        long long current = 0;
+        for (size_t i = 0; i < wordCount; i++) {
+            uint64_t used = words[i].load(memory_order_relaxed);
+            for (int bit = 0; bit < 64; bit++) {
+                current = ((used >> bit) & 1) ? 0 : current + 1;
+                best = max(best, current);
+            }
+        }
+        return best * CHUNK_SIZE;
+    }
+
+    void freeExtentHistogram(long long buckets[FREE_HISTOGRAM_BUCKETS]) const override {
+        fill(buckets, buckets + FREE_HISTOGRAM_BUCKETS, 0);
+        long long current = 0;
+        for (size_t i = 0; i < wordCount; i++) {
+            uint64_t used = words[i].load(memory_order_relaxed);
+            for (int bit = 0; bit < 64; bit++) {
+                if (!((used >> bit) & 1)) {
+                    current++;
+                } else if (current > 0) {
+                    buckets[histogramBucket(current * CHUNK_SIZE)]++;
+                    current = 0;
+                }
+            }
+        }
+        if (current > 0) {
+            buckets[histogramBucket(current * CHUNK_SIZE)]++;
+        }
+    }
+
+    long long reservedSize(long long size) const override {
+        long long chunks = chunksFor(size);
+        return (chunks <= 64 ? chunks : (chunks + 63) / 64 * 64) * CHUNK_SIZE;
+    }
+};
+
+unique_ptr<AllocationPolicy> makeAllocationPolicy(AllocatorBackend backend, long long size) {
+    switch (backend) {
+        case AllocatorBackend::Buddy: return make_unique<BuddyAllocator>(size);
+        case AllocatorBackend::LockFreeBitmap: return make_unique<AtomicChunkBitmap>(size);
+        default: return make_unique<FreeExtentIndex>(size);
+    }
+}
+
+const char* backendName(AllocatorBackend backend) {
+    switch (backend) {
+        case AllocatorBackend::Buddy: return "伙伴系统";
+        case AllocatorBackend::LockFreeBitmap: return "无锁位图";
+        default: return "空闲区间索引";
+    }
+}
+
+// 线程缓存的尺寸类别：1~128 字节按 16/32/64/128 取整，另加 cpuWork 固定申请的 4KB
+constexpr int SIZE_CLASS_COUNT = 5;
+constexpr long long SIZE_CLASSES[SIZE_CLASS_COUNT] = {16, 32, 64, 128, 4 * 1024};
+constexpr size_t MAGAZINE_CAPACITY[SIZE_CLASS_COUNT] = {64, 64, 64, 64, 16};
+
+int sizeClassOf(long long size) {
+    for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+        if (size <= SIZE_CLASSES[i]) {
+            return (i < SIZE_CLASS_COUNT - 1 || size == SIZE_CLASSES[i]) ? i : -1;
+        }
+    }
+    return -1;
+}
+
+// 小对象 slab：从分配后端整块取 4KB，切成同一尺寸类别（16/32/64/128 字节）的槽，
+// 每个 slab 用位图记录空闲槽，申请时只需找到一个部分空闲的 slab 做一次位扫描；
+// 分配后端只看到整个 slab，看不到里面的小对象
+constexpr int SLAB_CLASS_COUNT = 4;
+constexpr long long SLAB_SIZE = 4 * 1024;
+constexpr long long SLAB_MAX_OBJECT = 128;
+
+class SlabAllocator {
+private:
+    struct Slab {
+        int sizeClass = 0;
+        int freeSlots = 0;
+        uint64_t freeMask[SLAB_SIZE / 16 / 64] = {};    // 置位表示空闲
+    };
+
+    AllocationPolicy& backing;
+    map<long long, Slab> slabs;                         // slab 起始地址 -> slab
+    set<long long> partialSlabs[SLAB_CLASS_COUNT];      // 还有空闲槽的 slab，优先用地址低的
+    size_t liveObjects = 0;
+
+    static int slotCount(int sizeClass) {
+        return static_cast<int>(SLAB_SIZE / SIZE_CLASSES[sizeClass]);
+    }
+
+public:
+    explicit SlabAllocator(AllocationPolicy& policy) : backing(policy) {}
+
+    static bool handles(long long size) {
+        return size <= SLAB_MAX_OBJECT;
+    }
+
+    static int classOf(long long size) {
+        int sizeClass = 0;
+        while (SIZE_CLASSES[sizeClass] < size) {
+            sizeClass++;
+        }
+        return sizeClass;
+    }
+
+    bool take(long long size, long long& start) {
+        int sizeClass = classOf(size);
+        if (partialSlabs[sizeClass].empty()) {
+            long long slabStart;
+            if (!backing.take(SLAB_SIZE, slabStart)) {
+                return false;
+            }
+            Slab& slab = slabs[slabStart];
+            slab.sizeClass = sizeClass;
+            slab.freeSlots = slotCount(sizeClass);
+            for (int i = 0; i < slab.freeSlots; i++) {
+                slab.freeMask[i / 64] |= 1ULL << (i % 64);
+            }
+            partialSlabs[sizeClass].insert(slabStart);
+        }
+
+        long long slabStart = *partialSlabs[sizeClass].begin();
+        Slab& slab = slabs[slabStart];
+        int word = 0;
+        while (slab.freeMask[word] == 0) {
+            word++;
+        }
+        int bit = __builtin_ctzll(slab.freeMask[word]);
+        slab.freeMask[word] &= ~(1ULL << bit);
+        if (--slab.freeSlots == 0) {
+            partialSlabs[sizeClass].erase(slabStart);
+        }
+        start = slabStart + (word * 64 + bit) * SIZE_CLASSES[sizeClass];
+        liveObjects++;
+        return true;
+    }
+
+    bool release(long long start, long long size) {
+        auto it = slabs.upper_bound(start);
+        if (it == slabs.begin()) {
+            return false;
+        }
+        --it;
+        long long slabStart = it->first;
+        Slab& slab = it->second;
+        long long objectSize = SIZE_CLASSES[slab.sizeClass];
+        long long offset = start - slabStart;
+        if (offset >= SLAB_SIZE || offset % objectSize != 0 || classOf(size) != slab.sizeClass) {
+            return false;
+        }
+        int slot = static_cast<int>(offset / objectSize);
+        uint64_t mask = 1ULL << (slot % 64);
+        if (slab.freeMask[slot / 64] & mask) {
+            return false;
+        }
+
+        slab.freeMask[slot / 64] |= mask;
+        slab.freeSlots++;
+        liveObjects--;
+        set<long long>& partial = partialSlabs[slab.sizeClass];
+        if (slab.freeSlots == 1) {
+            partial.insert(slabStart);
+        }
+        // 整个 slab 空了就还给分配后端，但每个类别至少留一个 slab 避免来回申请
+        if (slab.freeSlots == slotCount(slab.sizeClass) && partial.size() > 1) {
+            partial.erase(slabStart);
+            slabs.erase(it);
+            backing.release(slabStart, SLAB_SIZE);
+        }
+        return true;
+    }
+
+    size_t objectCount() const {
+        return liveObjects;
+    }
+
+    size_t slabCount() const {
+        return slabs.size();
+    }
+};
+
+// ===== 分配轨迹录制 =====
+
+enum class TraceOperation : uint8_t { Allocate = 0, AllocateFailed = 1, Deallocate = 2 };
+
+// 轨迹文件里的一条记录，定长 40 字节，按本机字节序直接写出
+struct TraceEvent {
+    uint64_t sequence;      // 全局顺序号，回放按它重建先后关系
+    uint64_t timestamp;     // 距录制开始的 steady_clock 纳秒数，可据此还原块的持有时间
+    uint64_t address;       // 块起始地址，作为块的标识（释放后可能被复用）
+    uint64_t size;
+    uint32_t threadIndex;   // 录制时的线程编号
+    TraceOperation operation;
+    uint8_t padding[3];
+};
+
+const char TRACE_MAGIC[4] = {'L', '1', 'T', 'R'};
+const uint32_t TRACE_VERSION = 2;     // 版本 2 增加了时间戳
+
+// 录制器：每个线程把记录追加到自己的缓冲区，不加锁；缓冲区攒满一块才加锁写进文件，
+// 内存占用与录制时长无关。文件里的记录按写出先后排列，回放时再按全局顺序号排序合并
+class AllocationTraceRecorder {
+private:
+    static constexpr size_t CHUNK_EVENTS = 4096;    // 每个线程缓冲区的容量（160KB）
+
+    struct ThreadBuffer {
+        uint32_t threadIndex = 0;
+        vector<TraceEvent> events;
+    };
+
+    // 线程当前所用的缓冲区及其所属录制器的编号；编号不复用，录制器释放后旧缓冲区不会被误用
+    struct LocalBuffer {
+        uint64_t recorderId = 0;
+        ThreadBuffer* buffer = nullptr;
+    };
+
+    static atomic<uint64_t> nextRecorderId;
+    static thread_local LocalBuffer localBuffer;
+
+    const uint64_t recorderId = nextRecorderId.fetch_add(1) + 1;
+    mutex buffersMutex;                             // 只在线程登记缓冲区和结束录制时使用
+    vector<unique_ptr<ThreadBuffer>> buffers;
+    mutex fileMutex;                                // 每攒满 CHUNK_EVENTS 条写一次文件时使用
+    ofstream file;
+    uint64_t writtenEvents = 0;                     // 受 fileMutex 保护
+    atomic<uint64_t> nextSequence{0};
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+    ThreadBuffer& threadBuffer() {
+        if (localBuffer.recorderId != recorderId) {
+            lock_guard<mutex> lock(buffersMutex);
+            buffers.push_back(make_unique<ThreadBuffer>());
+            buffers.back()->threadIndex = static_cast<uint32_t>(buffers.size() - 1);
+            buffers.back()->events.reserve(CHUNK_EVENTS);
+            localBuffer.recorderId = recorderId;
+            localBuffer.buffer = buffers.back().get();
+        }
+        return *localBuffer.buffer;
+    }
+
+    void writeChunk(vector<TraceEvent>& events) {
+        lock_guard<mutex> lock(fileMutex);
+        file.write(reinterpret_cast<const char*>(events.data()), events.size() * sizeof(TraceEvent));
+        writtenEvents += events.size();
+        events.clear();
+    }
+
+public:
+    // 打开文件并先写一个记录数为 0 的文件头，finish 时回填
+    explicit AllocationTraceRecorder(const string& path) : file(path, ios::binary) {
+        uint64_t count = 0;
+        file.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        file.write(reinterpret_cast<const char*>(&TRACE_VERSION), sizeof(TRACE_VERSION));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+
+    bool isOpen() const {
+        return static_cast<bool>(file);
+    }
+
+    void record(TraceOperation operation, long long address, long long size) {
+        ThreadBuffer& buffer = threadBuffer();
+        TraceEvent event = {};
+        event.sequence = nextSequence.fetch_add(1, memory_order_relaxed);
+        event.timestamp = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - startTime).count();
+        event.address = address;
+        event.size = size;
+        event.threadIndex = buffer.threadIndex;
+        event.operation = operation;
+        buffer.events.push_back(event);
+        if (buffer.events.size() == CHUNK_EVENTS) {
+            writeChunk(buffer.events);
+        }
+    }
+
+    // 写出各线程缓冲区里剩下的记录并回填记录数。调用前须停止录制，不能再有线程在调用 record
+    bool finish() {
+        lock_guard<mutex> lock(buffersMutex);
+        for (auto& buffer : buffers) {
+            if (!buffer->events.empty()) {
+                writeChunk(buffer->events);
+            }
+        }
+        lock_guard<mutex> fileLock(fileMutex);
+        file.seekp(sizeof(TRACE_MAGIC) + sizeof(TRACE_VERSION));
+        file.write(reinterpret_cast<const char*>(&writtenEvents), sizeof(writtenEvents));
+        file.close();
+        return !file.fail();
+    }
+
+    uint64_t eventCount() {
+        lock_guard<mutex> lock(fileMutex);
+        return writtenEvents;
+    }
+};
+
+atomic<uint64_t> AllocationTraceRecorder::nextRecorderId{0};
+thread_local AllocationTraceRecorder::LocalBuffer AllocationTraceRecorder::localBuffer;
+
+class MemoryManager;
+
+// 内存管理器的统计快照。空闲区间相关的数字由分配后端随申请释放增量维护（无锁后端除外，它扫描位图），
+// 字节数与失败、锁等待计数由内存管理器维护，取快照时不需要遍历已分配块
+struct AllocatorStats {
+    long long bytesInUse = 0;               // 调用方申请到且尚未释放的字节数（按申请大小计）
+    long long freeBytes = 0;
+    size_t freeExtentCount = 0;
+    long long freeExtentHistogram[FREE_HISTOGRAM_BUCKETS] = {};
+    long long largestFreeExtent = 0;
+    double externalFragmentation = 0;       // 1 - 最大空闲区间 / 空闲总量
+    long long allocationFailures = 0;
+    long long contendedLocks = 0;           // 没能立即拿到全局锁的次数
+    long long lockWaitNanos = 0;            // 这些次数里等锁的总时间
+};
+
+// 每个线程对每个内存管理器各有一份缓存（“弹匣”），常用尺寸的块直接在这里取还，不加锁；
+// 弹匣空了从全局成批补充，满了成批归还
+struct ThreadCache {
+    MemoryManager* owner = nullptr;
+    vector<long long> magazines[SIZE_CLASS_COUNT];
+    atomic<size_t> cachedBlocks{0};
+};
+
+// 线程退出时把本线程所有缓存归还给各自的内存管理器
+struct ThreadCacheHolder {
+    vector<unique_ptr<ThreadCache>> caches;
+    ~ThreadCacheHolder();
+};
+
+mutex cacheRegistryMutex;   // 保护线程缓存与内存管理器之间的登记关系
+thread_local ThreadCacheHolder localCaches;
+
+// 内存管理器：空闲空间由构造时选择的分配后端维护，已分配块按起始地址登记以便校验释放；
+// 开启线程缓存时，常用尺寸的申请和释放先走本线程的缓存
 class MemoryManager {
 private:
-    vector<MemoryBlock> allocatedBlocks;
+    unique_ptr<AllocationPolicy> policy;
+    AtomicChunkBitmap* lockFreePolicy;      // 无锁后端时非空，申请释放直接走它
+    SlabAllocator smallObjects;
+    unordered_map<long long, long long> allocatedBlocks;  // 起始地址 -> 大小（不含 slab 里的小对象）
     mutable mutex memoryMutex;
     long long totalMemory;
+    bool threadCacheEnabled;
+    vector<ThreadCache*> registeredCaches;  // 受 cacheRegistryMutex 保护
+    atomic<AllocationTraceRecorder*> recorder{nullptr};
+    PaddedCounter bytesInUse[COUNTER_SHARDS];
+    atomic<long long> allocationFailures{0};
+    atomic<long long> contendedLocks{0};
+    atomic<long long> lockWaitNanos{0};
+
+    // 先试着拿锁，拿不到才计时，不争用时不多读时钟
+    unique_lock<mutex> lockMemory() {
+        unique_lock<mutex> lock(memoryMutex, try_to_lock);
+        if (!lock.owns_lock()) {
+            auto begin = chrono::steady_clock::now();
+            lock.lock();
+            lockWaitNanos.fetch_add(chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now() - begin).count(), memory_order_relaxed);
+            contendedLocks.fetch_add(1, memory_order_relaxed);
+        }
+        return lock;
+    }
+
+    bool allocateLocked(long long size, long long& start) {
+        if (SlabAllocator::handles(size)) {
+            return smallObjects.take(size, start);
+        }
+        if (!policy->take(size, start)) {
+            return false;
+        }
+        allocatedBlocks.emplace(start, size);
+        return true;
+    }
+
+    void deallocateLocked(long long start, long long size) {
+        if (SlabAllocator::handles(size)) {
+            smallObjects.release(start, size);
+            return;
+        }
+        auto it = allocatedBlocks.find(start);
+        if (it != allocatedBlocks.end() && it->second == size) {
+            allocatedBlocks.erase(it);
+            policy->release(start, size);
+        }
+    }
+
+    ThreadCache* localCache() {
+        for (auto& cache : localCaches.caches) {
+            if (cache->owner == this) {
+                return cache.get();
+            }
+        }
+        lock_guard<mutex> lock(cacheRegistryMutex);
+        localCaches.caches.push_back(make_unique<ThreadCache>());
+        ThreadCache* cache = localCaches.caches.back().get();
+        cache->owner = this;
+        registeredCaches.push_back(cache);
+        return cache;
+    }
+
+    bool allocateCached(int sizeClass, long long& start) {
+        ThreadCache* cache = localCache();
+        vector<long long>& magazine = cache->magazines[sizeClass];
+        if (magazine.empty()) {
+            long long classSize = SIZE_CLASSES[sizeClass];
+            size_t batch = MAGAZINE_CAPACITY[sizeClass] / 2;
+            auto lock = lockMemory();
+            long long blockStart;
+            while (magazine.size() < batch && allocateLocked(classSize, blockStart)) {
+                magazine.push_back(blockStart);
+            }
+            if (magazine.empty()) {
+                return false;
+            }
+            cache->cachedBlocks.fetch_add(magazine.size(), memory_order_relaxed);
+        }
+        start = magazine.back();
+        magazine.pop_back();
+        cache->cachedBlocks.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+
+    void deallocateCached(int sizeClass, long long start) {
+        ThreadCache* cache = localCache();
+        vector<long long>& magazine = cache->magazines[sizeClass];
+        magazine.push_back(start);
+        cache->cachedBlocks.fetch_add(1, memory_order_relaxed);
+        if (magazine.size() >= MAGAZINE_CAPACITY[sizeClass]) {
+            drainMagazine(cache, sizeClass, MAGAZINE_CAPACITY[sizeClass] / 2);
+        }
+    }
+
+    void drainMagazine(ThreadCache* cache, int sizeClass, size_t keep) {
+        vector<long long>& magazine = cache->magazines[sizeClass];
+        if (magazine.size() <= keep) {
+            return;
+        }
+        size_t released = magazine.size() - keep;
+        {
+            auto lock = lockMemory();
+            for (size_t i = keep; i < magazine.size(); i++) {
+                deallocateLocked(magazine[i], SIZE_CLASSES[sizeClass]);
+            }
+        }
+        magazine.resize(keep);
+        cache->cachedBlocks.fetch_sub(released, memory_order_relaxed);
+    }
+
+    friend struct ThreadCacheHolder;
+
+    // 调用方需持有 cacheRegistryMutex
+    void releaseCache(ThreadCache* cache) {
+        for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+            drainMagazine(cache, i, 0);
+        }
+        registeredCaches.erase(remove(registeredCaches.begin(), registeredCaches.end(), cache),
+                               registeredCaches.end());
+        cache->owner = nullptr;
+    }
     
 public:
-    MemoryManager(long long size) : totalMemory(size) {}
+    MemoryManager(long long size, AllocatorBackend backend = AllocatorBackend::ExtentIndex,
+                  bool enableThreadCache = true)
+        : policy(makeAllocationPolicy(backend, size)),
+          lockFreePolicy(policy->lockFree() ? static_cast<AtomicChunkBitmap*>(policy.get()) : nullptr),
+          smallObjects(*policy), totalMemory(size),
+          threadCacheEnabled(enableThreadCache && lockFreePolicy == nullptr) {}
+
+    ~MemoryManager() {
+        lock_guard<mutex> lock(cacheRegistryMutex);
+        for (ThreadCache* cache : registeredCaches) {
+            cache->owner = nullptr;
+        }
+    }
+
+    MemoryManager(const MemoryManager&) = delete;
+    MemoryManager& operator=(const MemoryManager&) = delete;
     
     unique_ptr<MemoryBlock> allocate(long long size) {
         if (size > MAX_BLOCK_SIZE || size <= 0) {
             return nullptr;
         }
         
-        lock_guard<mutex> lock(memoryMutex);
-        
-        // 简单地从0开始分配，检查是否重叠
         long long start = 0;
-        bool found = false;
-        
-        // 如果没有已分配块，直接分配
-        if (allocatedBlocks.empty()) {
-            if (size <= totalMemory) {
-                found = true;
+        int sizeClass = threadCacheEnabled ? sizeClassOf(size) : -1;
+        if (lockFreePolicy != nullptr) {
+            if (!lockFreePolicy->take(size, start)) {
+                start = -1;
+            }
+        } else if (sizeClass >= 0) {
+            if (!allocateCached(sizeClass, start)) {
+                start = -1;
             }
         } else {
-            // 检查第一个块之前
-            if (allocatedBlocks[0].start >= size) {
-                start = 0;
-                found = true;
-            } else {
-                // 检查块之间
-                for (size_t i = 0; i < allocatedBlocks.size() - 1; i++) {
-                    long long gap = allocatedBlocks[i + 1].start - (allocatedBlocks[i].start + allocatedBlocks[i].size);
-                    if (gap >= size) {
-                        start = allocatedBlocks[i].start + allocatedBlocks[i].size;
-                        found = true;
-                        break;
-                    }
-                }
-                
-                // 检查最后一个块之后
-                if (!found) {
-                    long long lastEnd = allocatedBlocks.back().start + allocatedBlocks.back().size;
-                    if (totalMemory - lastEnd >= size) {
-                        start = lastEnd;
-                        found = true;
-                    }
-                }
+            auto lock = lockMemory();
+            if (!allocateLocked(size, start)) {
+                start = -1;
             }
         }
-        
-        if (found) {
-            auto newBlock = make_unique<MemoryBlock>(start, size);
-            allocatedBlocks.push_back(*newBlock);
-            // 按起始地址排序
-            sort(allocatedBlocks.begin(), allocatedBlocks.end(),
-                [](const MemoryBlock& a, const MemoryBlock& b) {
-                    return a.start < b.start;
-                });
-            return newBlock;
+        // 顺序号在申请完成后取，保证同一地址上一次释放的记录排在前面
+        AllocationTraceRecorder* trace = recorder.load(memory_order_relaxed);
+        if (trace != nullptr) {
+            trace->record(start < 0 ? TraceOperation::AllocateFailed : TraceOperation::Allocate, start, size);
         }
+        if (start < 0) {
+            allocationFailures.fetch_add(1, memory_order_relaxed);
+            return nullptr;
+        }
+        bytesInUse[threadShard()].value.fetch_add(size, memory_order_relaxed);
+        return make_unique<MemoryBlock>(start, size);
+    }
+    
+    void deallocate(unique_ptr<MemoryBlock> block) {
+        if (!block) return;
         
-        return nullptr;
+        // 顺序号在真正归还前取，保证排在复用该地址的下一次申请之前
+        AllocationTraceRecorder* trace = recorder.load(memory_order_relaxed);
+        if (trace != nullptr) {
+            trace->record(TraceOperation::Deallocate, block->start, block->size);
+        }
+        bytesInUse[threadShard()].value.fetch_sub(block->size, memory_order_relaxed);
+        int sizeClass = threadCacheEnabled ? sizeClassOf(block->size) : -1;
+        if (lockFreePolicy != nullptr) {
+            lockFreePolicy->release(block->start, block->size);
+        } else if (sizeClass >= 0) {
+            deallocateCached(sizeClass, block->start);
+        } else {
+            auto lock = lockMemory();
+            deallocateLocked(block->start, block->size);
+        }
+    }
+    
+    // 不计入仍留在线程缓存里的空闲块
+    size_t getAllocatedBlockCount() const {
+        if (lockFreePolicy != nullptr) {
+            return lockFreePolicy->liveBlockCount();
+        }
+        size_t cached = 0;
+        {
+            lock_guard<mutex> lock(cacheRegistryMutex);
+            for (ThreadCache* cache : registeredCaches) {
+                cached += cache->cachedBlocks.load(memory_order_relaxed);
+            }
+        }
+        lock_guard<mutex> lock(memoryMutex);
+        size_t blocks = allocatedBlocks.size() + smallObjects.objectCount();
+        return blocks - min(cached, blocks);
+    }
+
+    size_t getSlabCount() const {
+        lock_guard<mutex> lock(memoryMutex);
+        return smallObjects.slabCount();
+    }
+
+    size_t getFreeExtentCount() const {
+        lock_guard<mutex> lock(memoryMutex);
+        return policy->extentCount();
+    }
+
+    // 外部碎片率：1 - 最大空闲区间 / 空闲总量
+    double getExternalFragmentation() const {
+        lock_guard<mutex> lock(memoryMutex);
+        long long freeBytes = policy->freeBytes();
+        return freeBytes == 0 ? 0.0 : 1.0 - static_cast<double>(policy->largestFreeExtent()) / freeBytes;
+    }
+
+    AllocatorStats getStats() const {
+        AllocatorStats stats;
+        {
+            unique_lock<mutex> lock(memoryMutex, defer_lock);
+            if (lockFreePolicy == nullptr) {
+                lock.lock();
+            }
+            stats.freeBytes = policy->freeBytes();
+            stats.freeExtentCount = policy->extentCount();
+            stats.largestFreeExtent = policy->largestFreeExtent();
+            policy->freeExtentHistogram(stats.freeExtentHistogram);
+        }
+        stats.externalFragmentation = stats.freeBytes == 0 ? 0.0 :
+            1.0 - static_cast<double>(stats.largestFreeExtent) / stats.freeBytes;
+        stats.bytesInUse = sumShards(bytesInUse);
+        stats.allocationFailures = allocationFailures.load(memory_order_relaxed);
+        stats.contendedLocks = contendedLocks.load(memory_order_relaxed);
+        stats.lockWaitNanos = lockWaitNanos.load(memory_order_relaxed);
+        return stats;
+    }
+
+    // 开始或停止（传 nullptr）录制分配轨迹；录制器须比录制期间的所有调用活得久
+    void setTraceRecorder(AllocationTraceRecorder* traceRecorder) {
+        recorder.store(traceRecorder);
+    }
+
+    long long getReservedSize(long long size) const {
+        if (lockFreePolicy == nullptr && SlabAllocator::handles(size)) {
+            return SIZE_CLASSES[SlabAllocator::classOf(size)];
+        }
+        return policy->reservedSize(size);
+    }
+};
+
+ThreadCacheHolder::~ThreadCacheHolder() {
+    lock_guard<mutex> lock(cacheRegistryMutex);
+    for (auto& cache : caches) {
+        if (cache->owner != nullptr) {
+            cache->owner->releaseCache(cache.get());
+        }
+    }
+}
+
+// 全局内存管理器
+MemoryManager memoryManager(SizeOfStack);
+
+// SplitMix64：状态只是一个计数器，每次输出都是充分混合的 64 位值，
+// 适合把 (主种子, 线程编号) 这类相近的输入展开成互不相关的种子
+class SplitMix64 {
+private:
+    uint64_t state;
+
+public:
+    typedef uint64_t result_type;
+
+    explicit SplitMix64(uint64_t seed) : state(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+// xoshiro256**：32 字节状态，每次几条移位和乘法，比 mt19937 的 2.5KB 状态轻得多，
+// 可直接配合标准库的各种分布使用
+class Xoshiro256 {
+private:
+    uint64_t state[4];
+
+    static uint64_t rotateLeft(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
     }
-    
-    void deallocate(unique_ptr<MemoryBlock> block) {
-        if (!block) return;
-        
-        lock_guard<mutex> lock(memoryMutex);
-        auto it = find(allocatedBlocks.begin(), allocatedBlocks.end(), *block);
-        if (it != allocatedBlocks.end()) {
-            allocatedBlocks.erase(it);
+
+public:
+    typedef uint64_t result_type;
+
+    explicit Xoshiro256(uint64_t seed) {
+        SplitMix64 seeder(seed);
+        for (auto& word : state) {
+            word = seeder();
         }
     }
-    
-    size_t getAllocatedBlockCount() const {
-        lock_guard<mutex> lock(memoryMutex);
-        return allocatedBlocks.size();
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()() {
+        uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotateLeft(state[3], 45);
+        return result;
     }
 };
 
-// 全局内存管理器
-MemoryManager memoryManager(SizeOfStack);
+// 由主种子和线程编号得到该线程的种子，同样的输入总得到同样的随机序列
+uint64_t threadSeed(uint64_t masterSeed, uint64_t threadIndex) {
+    SplitMix64 mixer(masterSeed ^ (threadIndex * 0xD1B54A32D192ED03ULL));
+    return mixer();
+}
 
-// 线程安全的随机数生成器
+// 线程安全的随机数生成器：每个线程一个 xoshiro256**，互不共享，取数不加锁。
+// 线程的种子由主种子和线程编号决定；线程可以用 bindThread 指定编号（如 CPU 号），
+// 否则按首次使用的先后自动编号。setSeed 之后各线程在下次取数时按新种子重新播种
 class ThreadSafeRandom {
 private:
-    static mt19937& getGenerator() {
-        static mutex mtx;
-        lock_guard<mutex> lock(mtx);
-        static mt19937 generator(random_device{}());
-        return generator;
+    static atomic<uint64_t> masterSeed;
+    static atomic<uint64_t> seedGeneration;
+    static atomic<uint64_t> nextThreadIndex;
+
+    struct LocalState {
+        uint64_t threadIndex = UINT64_MAX;
+        uint64_t generation = UINT64_MAX;
+        Xoshiro256 generator{0};
+    };
+
+    static LocalState& local() {
+        thread_local LocalState state;
+        return state;
+    }
+
+    static Xoshiro256& getGenerator() {
+        LocalState& state = local();
+        uint64_t generation = seedGeneration.load(memory_order_acquire);
+        if (state.generation != generation) {
+            if (state.threadIndex == UINT64_MAX) {
+                state.threadIndex = nextThreadIndex.fetch_add(1, memory_order_relaxed);
+            }
+            state.generator = Xoshiro256(threadSeed(masterSeed.load(memory_order_relaxed), state.threadIndex));
+            state.generation = generation;
+        }
+        return state.generator;
     }
     
 public:
+    // 在启动工作线程之前调用，之后的随机序列完全由 seed 和各线程编号决定
+    static void setSeed(uint64_t seed) {
+        masterSeed.store(seed, memory_order_relaxed);
+        seedGeneration.fetch_add(1, memory_order_release);
+    }
+
+    // 指定当前线程的编号，让它的随机序列不依赖线程启动的先后
+    static void bindThread(uint64_t threadIndex) {
+        LocalState& state = local();
+        state.threadIndex = threadIndex;
+        state.generation = UINT64_MAX;
+    }
+
     static int getInt(int min, int max) {
         uniform_int_distribution<int> distribution(min, max);
         return distribution(getGenerator());
@@ -139,23 +1238,256 @@ public:
     }
 };
 
-// 线程安全的输出
+atomic<uint64_t> ThreadSafeRandom::masterSeed{random_device{}()};
+atomic<uint64_t> ThreadSafeRandom::seedGeneration{0};
+atomic<uint64_t> ThreadSafeRandom::nextThreadIndex{0};
+
+// ===== 异步日志 =====
+
+// 日志事件类型：工作线程只写事件号和几个整数，格式化留给后台线程
+enum class LogEvent : uint8_t {
+    CpuStart,
+    AllocateAttempt,    // values[0] = 大小
+    AllocateFailed,
+    Allocated,          // values[0] = 起始地址，values[1] = 大小
+    Released,
+    CpuEnd
+};
+
+// 定长日志记录，写入环形缓冲区时只是一次内存拷贝
+struct LogRecord {
+    uint64_t timestamp;         // steady_clock 纳秒，后台线程按它合并各线程的记录
+    int64_t values[2];
+    int32_t cpu;
+    LogEvent event;
+};
+
+// 单生产者单消费者环形缓冲区：只有所属线程写 tail，只有后台线程写 head。
+// 满了不等待，直接丢弃并计数
+class LogRing {
+private:
+    static constexpr size_t CAPACITY = 1024;    // 2 的幂
+    LogRecord records[CAPACITY];
+    alignas(64) atomic<size_t> head{0};
+    alignas(64) atomic<size_t> tail{0};
+    alignas(64) atomic<long long> dropped{0};
+
+public:
+    atomic<bool> closed{false};                 // 所属线程已退出，读空后即可回收
+
+    bool push(const LogRecord& record) {
+        size_t position = tail.load(memory_order_relaxed);
+        if (position - head.load(memory_order_acquire) == CAPACITY) {
+            dropped.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+        records[position % CAPACITY] = record;
+        tail.store(position + 1, memory_order_release);
+        return true;
+    }
+
+    size_t popAll(vector<LogRecord>& out) {
+        size_t first = head.load(memory_order_relaxed);
+        size_t last = tail.load(memory_order_acquire);
+        for (size_t i = first; i != last; i++) {
+            out.push_back(records[i % CAPACITY]);
+        }
+        head.store(last, memory_order_release);
+        return last - first;
+    }
+
+    bool empty() const {
+        return head.load(memory_order_relaxed) == tail.load(memory_order_acquire);
+    }
+
+    long long droppedCount() const {
+        return dropped.load(memory_order_relaxed);
+    }
+};
+
+// 异步日志器：每个线程第一次写日志时登记一个环形缓冲区，
+// 一个后台线程把所有缓冲区读空，按时间排序、格式化后一次写出；没有日志时睡眠，由写日志的线程唤醒
+class AsyncLogger {
+private:
+    static constexpr auto IDLE_TIMEOUT = chrono::milliseconds(100);    // 睡眠的兜底时长
+
+    mutex registryMutex;                        // 只在登记缓冲区和后台线程巡检时使用
+    vector<shared_ptr<LogRing>> rings;
+    long long retiredDrops = 0;                 // 已回收缓冲区的丢弃数
+    atomic<bool> running{true};
+    atomic<bool> sleeping{false};               // 后台线程准备睡眠或正在睡眠，由第一个写日志的线程清除并唤醒
+    mutex wakeMutex;
+    condition_variable wakeup;
+    thread drainer;
+
+    struct RingHolder {
+        shared_ptr<LogRing> ring;
+        ~RingHolder() {
+            if (ring) ring->closed.store(true, memory_order_release);
+        }
+    };
+
+    static void format(const LogRecord& record, string& out) {
+        out += "CPU ";
+        out += to_string(record.cpu);
+        switch (record.event) {
+            case LogEvent::CpuStart: out += " 开始工作。"; break;
+            case LogEvent::AllocateAttempt: out += " 尝试申请 " + to_string(record.values[0]) + " 字节内存。"; break;
+            case LogEvent::AllocateFailed: out += " 内存申请失败。"; break;
+            case LogEvent::Allocated:
+                out += " 成功申请内存：起始地址=" + to_string(record.values[0]) + "，大小=" + to_string(record.values[1]);
+                break;
+            case LogEvent::Released: out += " 已释放内存块。"; break;
+            default: out += " 工作结束。"; break;
+        }
+        out += '\n';
+    }
+
+    // 读空所有缓冲区并写出，返回写出的条数
+    size_t drainOnce(vector<LogRecord>& batch, string& text) {
+        batch.clear();
+        {
+            lock_guard<mutex> lock(registryMutex);
+            for (size_t i = 0; i < rings.size();) {
+                // 先看 closed 再读，保证退出线程最后写入的记录不会漏掉
+                bool closed = rings[i]->closed.load(memory_order_acquire);
+                rings[i]->popAll(batch);
+                if (closed) {
+                    retiredDrops += rings[i]->droppedCount();
+                    rings[i] = rings.back();
+                    rings.pop_back();
+                } else {
+                    i++;
+                }
+            }
+        }
+        if (batch.empty()) {
+            return 0;
+        }
+        stable_sort(batch.begin(), batch.end(),
+                    [](const LogRecord& a, const LogRecord& b) { return a.timestamp < b.timestamp; });
+        text.clear();
+        for (const LogRecord& record : batch) {
+            format(record, text);
+        }
+        cout.write(text.data(), text.size());
+        cout.flush();
+        return batch.size();
+    }
+
+    bool hasPending() {
+        lock_guard<mutex> lock(registryMutex);
+        for (const auto& ring : rings) {
+            if (!ring->empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 先置 sleeping 再检查缓冲区，与 write 中先写记录再查 sleeping 配对：
+    // 要么这里看到新记录，要么写日志的线程看到 sleeping 并唤醒，不会漏掉
+    void waitForRecords() {
+        unique_lock<mutex> lock(wakeMutex);
+        sleeping.store(true);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (!hasPending()) {
+            wakeup.wait_for(lock, IDLE_TIMEOUT, [this]() {
+                return !sleeping.load() || !running.load(memory_order_acquire);
+            });
+        }
+        sleeping.store(false);
+    }
+
+    void drainLoop() {
+        vector<LogRecord> batch;
+        string text;
+        while (running.load(memory_order_acquire)) {
+            if (drainOnce(batch, text) == 0) {
+                waitForRecords();
+            }
+        }
+        while (drainOnce(batch, text) > 0) {}
+    }
+
+    LogRing& localRing() {
+        thread_local RingHolder holder;
+        if (!holder.ring) {
+            holder.ring = make_shared<LogRing>();
+            lock_guard<mutex> lock(registryMutex);
+            rings.push_back(holder.ring);
+        }
+        return *holder.ring;
+    }
+
+public:
+    AsyncLogger() : drainer(&AsyncLogger::drainLoop, this) {}
+
+    ~AsyncLogger() {
+        shutdown();
+    }
+
+    void write(LogEvent event, int cpu, long long first, long long second) {
+        LogRecord record;
+        record.timestamp = chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+        record.values[0] = first;
+        record.values[1] = second;
+        record.cpu = cpu;
+        record.event = event;
+        localRing().push(record);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (sleeping.load(memory_order_relaxed) && sleeping.exchange(false)) {
+            lock_guard<mutex> lock(wakeMutex);
+            wakeup.notify_one();
+        }
+    }
+
+    // 写出所有已提交的记录并停止后台线程；之后的日志不再输出
+    void shutdown() {
+        if (running.exchange(false)) {
+            {
+                lock_guard<mutex> lock(wakeMutex);
+            }
+            wakeup.notify_one();
+            drainer.join();
+        }
+    }
+
+    long long droppedCount() {
+        lock_guard<mutex> lock(registryMutex);
+        long long total = retiredDrops;
+        for (const auto& ring : rings) {
+            total += ring->droppedCount();
+        }
+        return total;
+    }
+};
+
+// 线程安全的输出：记录写进本线程的环形缓冲区立即返回，由后台线程统一输出
 class Logger {
 private:
-    static mutex outputMutex;
+    static AsyncLogger& instance() {
+        static AsyncLogger logger;
+        return logger;
+    }
     
 public:
-    static void log(const string& message) {
-        lock_guard<mutex> lock(outputMutex);
-        cout << message << endl;
+    static void log(LogEvent event, int cpu, long long first = 0, long long second = 0) {
+        instance().write(event, cpu, first, second);
     }
-};
 
-mutex Logger::outputMutex;
+    // 程序结束前调用，确保日志全部输出；返回因缓冲区满而丢弃的条数
+    static long long shutdown() {
+        instance().shutdown();
+        return instance().droppedCount();
+    }
+};
 
 // CPU工作函数
 void cpuWork(int cpuNumber) {
-    Logger::log("CPU " + to_string(cpuNumber) + " 开始工作。");
+    ThreadSafeRandom::bindThread(cpuNumber);
+    Logger::log(LogEvent::CpuStart, cpuNumber);
     
     for (int i = 0; i < TASK_OF_EACH_CPU; i++) {
         // 简化内存大小选择
@@ -169,29 +1501,709 @@ void cpuWork(int cpuNumber) {
             default: memorySize = 128;
         }
         
-        Logger::log("CPU " + to_string(cpuNumber) + " 尝试申请 " + to_string(memorySize) + " 字节内存。");
+        Logger::log(LogEvent::AllocateAttempt, cpuNumber, memorySize);
         
         auto memoryBlock = memoryManager.allocate(memorySize);
         if (!memoryBlock) {
-            Logger::log("CPU " + to_string(cpuNumber) + " 内存申请失败。");
+            Logger::log(LogEvent::AllocateFailed, cpuNumber);
             continue;
         }
         
-        Logger::log("CPU " + to_string(cpuNumber) + " 成功申请内存：起始地址=" + 
-                   to_string(memoryBlock->start) + "，大小=" + to_string(memoryBlock->size));
+        Logger::log(LogEvent::Allocated, cpuNumber, memoryBlock->start, memoryBlock->size);
         
         // 短暂等待
         this_thread::sleep_for(chrono::milliseconds(100));
         
         // 释放内存
         memoryManager.deallocate(move(memoryBlock));
-        Logger::log("CPU " + to_string(cpuNumber) + " 已释放内存块。");
+        Logger::log(LogEvent::Released, cpuNumber);
     }
     
-    Logger::log("CPU " + to_string(cpuNumber) + " 工作结束。");
+    Logger::log(LogEvent::CpuEnd, cpuNumber);
+}
+
+// 空闲区间索引性能测试：先建立 10 万个存活块，再做释放一个随机块、申请一个随机大小块的交替操作
+void benchmarkExtentIndex() {
+    constexpr int LIVE_BLOCKS = 100000;
+    constexpr int OPERATIONS = 1000000;
+    MemoryManager manager(SizeOfStack);
+    mt19937 generator(12345);
+    uniform_int_distribution<long long> sizeDistribution(1, 1024);
+
+    vector<unique_ptr<MemoryBlock>> liveBlocks;
+    liveBlocks.reserve(LIVE_BLOCKS);
+    while ((int)liveBlocks.size() < LIVE_BLOCKS) {
+        auto block = manager.allocate(sizeDistribution(generator));
+        if (!block) break;
+        liveBlocks.push_back(move(block));
+    }
+
+    int failures = 0;
+    auto startTime = chrono::steady_clock::now();
+    for (int i = 0; i < OPERATIONS; i++) {
+        size_t victim = uniform_int_distribution<size_t>(0, liveBlocks.size() - 1)(generator);
+        manager.deallocate(move(liveBlocks[victim]));
+        liveBlocks[victim] = manager.allocate(sizeDistribution(generator));
+        if (!liveBlocks[victim]) {
+            failures++;
+            liveBlocks[victim] = manager.allocate(1);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+    cout << "存活块数: " << manager.getAllocatedBlockCount()
+         << "，空闲区间数: " << manager.getFreeExtentCount()
+         << "，小对象 slab 数: " << manager.getSlabCount() << endl;
+    cout << "释放+申请 " << OPERATIONS << " 次，耗时 " << seconds << " 秒，吞吐量 "
+         << static_cast<long long>(2 * OPERATIONS / seconds) << " 次操作/秒，申请失败 " << failures << " 次" << endl;
+}
+
+// 多线程扩展性测试：每个线程反复申请/释放常用尺寸的小块，对比有无线程缓存的吞吐量
+void benchmarkThreadCache() {
+    constexpr int OPERATIONS_PER_THREAD = 200000;
+    constexpr int LIVE_PER_THREAD = 32;
+
+    for (int threads : {1, 2, 4, 8}) {
+        for (bool cached : {false, true}) {
+            MemoryManager manager(SizeOfStack, AllocatorBackend::ExtentIndex, cached);
+            auto startTime = chrono::steady_clock::now();
+            vector<thread> workers;
+            for (int t = 0; t < threads; t++) {
+                workers.emplace_back([&manager, t]() {
+                    mt19937 generator(1000 + t);
+                    vector<unique_ptr<MemoryBlock>> ring(LIVE_PER_THREAD);
+                    for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+                        auto& slot = ring[i % LIVE_PER_THREAD];
+                        manager.deallocate(move(slot));
+                        long long size = (generator() % 3 == 0) ? 4 * 1024 : generator() % 128 + 1;
+                        slot = manager.allocate(size);
+                    }
+                    for (auto& block : ring) {
+                        manager.deallocate(move(block));
+                    }
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+            cout << threads << " 线程，" << (cached ? "线程缓存" : "全局锁  ") << ": "
+                 << static_cast<long long>(2.0 * OPERATIONS_PER_THREAD * threads / seconds) << " 次操作/秒"
+                 << "，结束时分配块数 " << manager.getAllocatedBlockCount() << endl;
+        }
+    }
+}
+
+// 后端对比：两种后端跑同一个固定种子的随机负载（cpuWork 的三类大小，维持 200 个存活块随机释放），
+// 比较平均延迟、申请失败次数、内部浪费和外部碎片
+void compareBackends() {
+    constexpr int OPERATIONS = 200000;
+    constexpr int LIVE_BLOCKS = 200;
+
+    for (AllocatorBackend backend : {AllocatorBackend::ExtentIndex, AllocatorBackend::Buddy}) {
+        MemoryManager manager(SizeOfStack, backend, false);
+        mt19937 generator(2024);
+        vector<unique_ptr<MemoryBlock>> liveBlocks(LIVE_BLOCKS);
+        int failures = 0;
+        long long requestedBytes = 0;
+        long long reservedBytes = 0;
+        double worstFragmentation = 0;
+
+        auto startTime = chrono::steady_clock::now();
+        for (int i = 0; i < OPERATIONS; i++) {
+            auto& slot = liveBlocks[generator() % LIVE_BLOCKS];
+            if (slot) {
+                requestedBytes -= slot->size;
+                reservedBytes -= manager.getReservedSize(slot->size);
+                manager.deallocate(move(slot));
+            }
+
+            long long size;
+            switch (generator() % 3) {
+                case 0: size = generator() % 128 + 1; break;
+                case 1: size = 4 * 1024; break;
+                default: size = 4 * 1024 + generator() % (1 * 1024 * 1024 - 4 * 1024 + 1); break;
+            }
+            slot = manager.allocate(size);
+            if (!slot) {
+                failures++;
+                continue;
+            }
+            requestedBytes += size;
+            reservedBytes += manager.getReservedSize(size);
+            if (i % 1000 == 0) {
+                worstFragmentation = max(worstFragmentation, manager.getExternalFragmentation());
+            }
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+        cout << backendName(backend) << ": 平均每次释放+申请 " << seconds * 1e9 / OPERATIONS << " ns，"
+             << "申请失败 " << failures << " 次，内部浪费 "
+             << (requestedBytes == 0 ? 0.0 : 100.0 * (reservedBytes - requestedBytes) / reservedBytes) << "%，"
+             << "最大外部碎片率 " << worstFragmentation * 100 << "%" << endl;
+    }
+}
+
+// 竞争测试：1~16 个线程同时申请/释放（cpuWork 的三类大小，每线程维持 32 个存活块），
+// 对比加全局锁的空闲区间索引与无锁位图后端
+void benchmarkContention() {
+    constexpr int OPERATIONS_PER_THREAD = 100000;
+    constexpr int LIVE_PER_THREAD = 32;
+
+    for (int threads : {1, 2, 4, 8, 16}) {
+        for (AllocatorBackend backend : {AllocatorBackend::ExtentIndex, AllocatorBackend::LockFreeBitmap}) {
+            MemoryManager manager(SizeOfStack, backend, false);
+            atomic<long long> failures{0};
+            auto startTime = chrono::steady_clock::now();
+            vector<thread> workers;
+            for (int t = 0; t < threads; t++) {
+                workers.emplace_back([&manager, &failures, t]() {
+                    mt19937 generator(3000 + t);
+                    vector<unique_ptr<MemoryBlock>> ring(LIVE_PER_THREAD);
+                    long long localFailures = 0;
+                    for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+                        auto& slot = ring[i % LIVE_PER_THREAD];
+                        manager.deallocate(move(slot));
+                        long long size;
+                        switch (generator() % 3) {
+                            case 0: size = generator() % 128 + 1; break;
+                            case 1: size = 4 * 1024; break;
+                            default: size = 4 * 1024 + generator() % (64 * 1024); break;
+                        }
+                        slot = manager.allocate(size);
+                        localFailures += slot ? 0 : 1;
+                    }
+                    for (auto& block : ring) {
+                        manager.deallocate(move(block));
+                    }
+                    failures += localFailures;
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+            cout << threads << " 线程，" << backendName(backend) << ": "
+                 << static_cast<long long>(2.0 * OPERATIONS_PER_THREAD * threads / seconds) << " 次操作/秒，"
+                 << "申请失败 " << failures << " 次，结束时分配块数 " << manager.getAllocatedBlockCount() << endl;
+        }
+    }
+}
+
+// ===== 可配置负载与吞吐量测试 =====
+
+enum class SizeDistribution {
+    Uniform,    // 1 ~ maxSize 均匀分布
+    Mix,        // cpuWork 的三类：1~128 字节、固定 4KB、4KB~1MB
+    LogNormal,  // 对数正态，中位数约 1KB
+    Trace       // 从文本文件逐个读取大小（每行一个），循环使用
+};
+
+enum class HoldDistribution {
+    Fixed,          // 每个块存活固定的操作数
+    Uniform,        // 1 ~ 2 倍均值之间均匀
+    Exponential     // 指数分布
+};
+
+struct WorkloadConfig {
+    int threads = 4;
+    long long operationsPerThread = 100000;
+    SizeDistribution sizeDistribution = SizeDistribution::Mix;
+    long long maxSize = 1 * 1024 * 1024;
+    vector<long long> traceSizes;
+    HoldDistribution holdDistribution = HoldDistribution::Exponential;
+    double meanHold = 64;               // 以本线程的操作数计
+    int liveLimit = 256;                // 每个线程最多同时持有的块数
+    AllocatorBackend backend = AllocatorBackend::ExtentIndex;
+    bool threadCache = true;
+    unsigned int seed = 1;
+    string recordPath;                  // 非空时把本次负载的分配轨迹录制到该文件
+};
+
+// 负载生成器：每个线程一个，按配置产生申请大小和存活时长
+class WorkloadGenerator {
+private:
+    const WorkloadConfig& config;
+    Xoshiro256 generator;
+    size_t traceCursor;
+
+public:
+    WorkloadGenerator(const WorkloadConfig& cfg, int threadIndex)
+        : config(cfg), generator(threadSeed(cfg.seed, threadIndex)),
+          traceCursor(cfg.traceSizes.empty() ? 0 : threadIndex * 7919 % cfg.traceSizes.size()) {}
+
+    long long nextSize() {
+        switch (config.sizeDistribution) {
+            case SizeDistribution::Uniform:
+                return uniform_int_distribution<long long>(1, config.maxSize)(generator);
+            case SizeDistribution::LogNormal: {
+                double size = lognormal_distribution<double>(log(1024.0), 1.5)(generator);
+                return max(1LL, min(config.maxSize, static_cast<long long>(size)));
+            }
+            case SizeDistribution::Trace: {
+                long long size = config.traceSizes[traceCursor];
+                traceCursor = (traceCursor + 1) % config.traceSizes.size();
+                return size;
+            }
+            default:
+                switch (generator() % 3) {
+                    case 0: return uniform_int_distribution<long long>(1, 128)(generator);
+                    case 1: return 4 * 1024;
+                    default: return uniform_int_distribution<long long>(4 * 1024, 1 * 1024 * 1024)(generator);
+                }
+        }
+    }
+
+    long long nextHold() {
+        switch (config.holdDistribution) {
+            case HoldDistribution::Fixed:
+                return max(1LL, static_cast<long long>(config.meanHold));
+            case HoldDistribution::Uniform:
+                return uniform_int_distribution<long long>(1, max(1LL, static_cast<long long>(2 * config.meanHold)))(generator);
+            default:
+                return 1 + static_cast<long long>(exponential_distribution<double>(1.0 / config.meanHold)(generator));
+        }
+    }
+};
+
+struct LatencySamples {
+    vector<uint32_t> allocateNanos;
+    vector<uint32_t> deallocateNanos;
+    long long failures = 0;
+};
+
+double percentile(vector<uint32_t>& samples, double fraction) {
+    if (samples.empty()) return 0;
+    size_t index = min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+    nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+// 打印统计快照；直方图只列出非空的桶
+void printAllocatorStats(const AllocatorStats& stats) {
+    cout << "使用中: " << stats.bytesInUse << " 字节，空闲: " << stats.freeBytes << " 字节，空闲区间: "
+         << stats.freeExtentCount << " 个，最大空闲区间: " << stats.largestFreeExtent << " 字节，外部碎片率: "
+         << stats.externalFragmentation * 100 << "%" << endl;
+    cout << "空闲区间大小分布:";
+    for (int k = 0; k < FREE_HISTOGRAM_BUCKETS; k++) {
+        if (stats.freeExtentHistogram[k] > 0) {
+            cout << " [2^" << k << (k == FREE_HISTOGRAM_BUCKETS - 1 ? "+" : "") << "]="
+                 << stats.freeExtentHistogram[k];
+        }
+    }
+    cout << endl;
+    cout << "申请失败: " << stats.allocationFailures << " 次，全局锁争用: " << stats.contendedLocks
+         << " 次，共等待 " << stats.lockWaitNanos / 1000 << " 微秒" << endl;
+}
+
+void runWorkloadThread(MemoryManager& manager, const WorkloadConfig& config, int threadIndex,
+                       LatencySamples& samples) {
+    typedef pair<long long, size_t> Expiry;    // (到期操作序号, 槽位)
+    WorkloadGenerator workload(config, threadIndex);
+    vector<unique_ptr<MemoryBlock>> live(config.liveLimit);
+    vector<size_t> freeSlots;
+    for (int i = config.liveLimit - 1; i >= 0; i--) {
+        freeSlots.push_back(i);
+    }
+    priority_queue<Expiry, vector<Expiry>, greater<Expiry>> expiries;
+    samples.allocateNanos.reserve(config.operationsPerThread);
+    samples.deallocateNanos.reserve(config.operationsPerThread);
+
+    auto release = [&](size_t slot) {
+        auto begin = chrono::steady_clock::now();
+        manager.deallocate(move(live[slot]));
+        samples.deallocateNanos.push_back(static_cast<uint32_t>(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count()));
+        freeSlots.push_back(slot);
+    };
+
+    for (long long op = 0; op < config.operationsPerThread; op++) {
+        // 先释放到期的块；存活块已满时提前释放最早到期的那个
+        while (!expiries.empty() && (expiries.top().first <= op || freeSlots.empty())) {
+            release(expiries.top().second);
+            expiries.pop();
+        }
+
+        long long size = workload.nextSize();
+        auto begin = chrono::steady_clock::now();
+        auto block = manager.allocate(size);
+        samples.allocateNanos.push_back(static_cast<uint32_t>(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count()));
+        if (!block) {
+            samples.failures++;
+            continue;
+        }
+        size_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        live[slot] = move(block);
+        expiries.push({op + workload.nextHold(), slot});
+    }
+    while (!expiries.empty()) {
+        release(expiries.top().second);
+        expiries.pop();
+    }
+}
+
+bool runWorkloadBenchmark(const WorkloadConfig& config) {
+    MemoryManager manager(SizeOfStack, config.backend, config.threadCache);
+    vector<LatencySamples> samples(config.threads);
+    atomic<bool> finished{false};
+    double peakFragmentation = 0;
+    long long peakBytesInUse = 0;
+
+    unique_ptr<AllocationTraceRecorder> recorder;
+    if (!config.recordPath.empty()) {
+        recorder = make_unique<AllocationTraceRecorder>(config.recordPath);
+        if (!recorder->isOpen()) {
+            cout << "无法创建轨迹文件: " << config.recordPath << endl;
+            return false;
+        }
+        manager.setTraceRecorder(recorder.get());
+    }
+
+    // 监控线程每 5ms 取一次统计快照，不在工作线程的关键路径上
+    thread monitor([&]() {
+        while (!finished.load()) {
+            AllocatorStats stats = manager.getStats();
+            peakFragmentation = max(peakFragmentation, stats.externalFragmentation);
+            peakBytesInUse = max(peakBytesInUse, stats.bytesInUse);
+            this_thread::sleep_for(chrono::milliseconds(5));
+        }
+    });
+
+    auto startTime = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < config.threads; t++) {
+        workers.emplace_back(runWorkloadThread, ref(manager), cref(config), t, ref(samples[t]));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    finished = true;
+    monitor.join();
+
+    bool traceSaved = true;
+    if (recorder) {
+        manager.setTraceRecorder(nullptr);
+        if (recorder->finish()) {
+            cout << "已录制 " << recorder->eventCount() << " 条分配轨迹到 " << config.recordPath << endl;
+        } else {
+            cout << "写入轨迹文件失败: " << config.recordPath << endl;
+            traceSaved = false;
+        }
+    }
+
+    LatencySamples merged;
+    for (auto& s : samples) {
+        merged.allocateNanos.insert(merged.allocateNanos.end(), s.allocateNanos.begin(), s.allocateNanos.end());
+        merged.deallocateNanos.insert(merged.deallocateNanos.end(), s.deallocateNanos.begin(), s.deallocateNanos.end());
+        merged.failures += s.failures;
+    }
+    size_t operations = merged.allocateNanos.size() + merged.deallocateNanos.size();
+
+    cout << "后端: " << backendName(config.backend) << (config.threadCache ? "（线程缓存）" : "")
+         << "，线程数: " << config.threads << "，每线程操作数: " << config.operationsPerThread
+         << "，每线程存活上限: " << config.liveLimit << endl;
+    cout << "吞吐量: " << static_cast<long long>(operations / seconds) << " 次操作/秒（申请 "
+         << merged.allocateNanos.size() << " 次，释放 " << merged.deallocateNanos.size()
+         << " 次，申请失败 " << merged.failures << " 次，耗时 " << seconds << " 秒）" << endl;
+    cout << "申请延迟 ns: p50=" << percentile(merged.allocateNanos, 0.5)
+         << " p99=" << percentile(merged.allocateNanos, 0.99)
+         << " p999=" << percentile(merged.allocateNanos, 0.999) << endl;
+    cout << "释放延迟 ns: p50=" << percentile(merged.deallocateNanos, 0.5)
+         << " p99=" << percentile(merged.deallocateNanos, 0.99)
+         << " p999=" << percentile(merged.deallocateNanos, 0.999) << endl;
+    cout << "峰值外部碎片率: " << peakFragmentation * 100 << "%，峰值使用中字节: " << peakBytesInUse << endl;
+    printAllocatorStats(manager.getStats());
+    return traceSaved;
+}
+
+// ===== 轨迹回放 =====
+
+// 回放用的一步：块编号在加载时重新分配，地址被复用的前后两个块编号不同
+struct ReplayStep {
+    TraceOperation operation;
+    uint32_t block;
+    long long size;
+};
+
+struct ReplayTrace {
+    vector<vector<ReplayStep>> threads;     // 按录制线程分组，组内保持原顺序
+    vector<ReplayStep> serial;              // 全部记录按全局顺序号排列
+    uint32_t blockCount = 0;
+    long long recordedFailures = 0;
+    long long holdSamples = 0;              // 录制期间申请并释放的块数
+    double totalHoldNanos = 0;              // 这些块按时间戳算出的持有时间之和
+};
+
+const uint32_t NO_BLOCK = UINT32_MAX;
+
+bool loadReplayTrace(const string& path, ReplayTrace& trace) {
+    ifstream file(path, ios::binary);
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t count = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || !equal(magic, magic + 4, TRACE_MAGIC) || version != TRACE_VERSION) {
+        return false;
+    }
+    // 记录条数必须和文件剩余长度一致，损坏的文件头不能导致按任意大小分配内存
+    streampos headerEnd = file.tellg();
+    file.seekg(0, ios::end);
+    uint64_t payloadBytes = static_cast<uint64_t>(file.tellg() - headerEnd);
+    file.seekg(headerEnd);
+    if (count != payloadBytes / sizeof(TraceEvent) || payloadBytes % sizeof(TraceEvent) != 0) {
+        return false;
+    }
+    vector<TraceEvent> events(count);
+    file.read(reinterpret_cast<char*>(events.data()), count * sizeof(TraceEvent));
+    if (!file) {
+        return false;
+    }
+    sort(events.begin(), events.end(),
+         [](const TraceEvent& a, const TraceEvent& b) { return a.sequence < b.sequence; });
+
+    unordered_map<uint64_t, uint32_t> liveBlocks;       // 地址 -> 当前块编号
+    vector<uint64_t> allocatedAt;                       // 块编号 -> 申请时间戳
+    unordered_map<uint32_t, size_t> threadSlots;        // 录制线程编号 -> 回放线程下标
+    trace.serial.reserve(count);
+    for (const TraceEvent& event : events) {
+        ReplayStep step = {event.operation, NO_BLOCK, static_cast<long long>(event.size)};
+        if (event.operation == TraceOperation::Allocate) {
+            step.block = trace.blockCount++;
+            liveBlocks[event.address] = step.block;
+            allocatedAt.push_back(event.timestamp);
+        } else if (event.operation == TraceOperation::Deallocate) {
+            auto it = liveBlocks.find(event.address);
+            if (it == liveBlocks.end()) {
+                continue;   // 录制开始前申请的块，回放时没有对应的申请
+            }
+            step.block = it->second;
+            liveBlocks.erase(it);
+            trace.holdSamples++;
+            trace.totalHoldNanos += static_cast<double>(event.timestamp - allocatedAt[step.block]);
+        } else {
+            trace.recordedFailures++;
+        }
+        auto slot = threadSlots.emplace(event.threadIndex, trace.threads.size());
+        if (slot.second) {
+            trace.threads.emplace_back();
+        }
+        trace.threads[slot.first->second].push_back(step);
+        trace.serial.push_back(step);
+    }
+    return true;
+}
+
+// 多线程回放：每个录制线程对应一个回放线程，按原顺序执行；
+// 释放别的线程申请的块时等待那次申请完成。申请总在释放之前，所以不会互相等死
+void replayThread(MemoryManager& manager, const vector<ReplayStep>& steps,
+                  vector<unique_ptr<MemoryBlock>>& blocks, atomic<uint8_t>* ready,
+                  atomic<long long>& failures, atomic<long long>& unexpectedSuccesses) {
+    for (const ReplayStep& step : steps) {
+        if (step.operation == TraceOperation::Deallocate) {
+            while (ready[step.block].load(memory_order_acquire) == 0) {
+                this_thread::yield();
+            }
+            manager.deallocate(move(blocks[step.block]));
+            continue;
+        }
+        auto block = manager.allocate(step.size);
+        if (!block) {
+            failures.fetch_add(1, memory_order_relaxed);
+        } else if (step.operation == TraceOperation::AllocateFailed) {
+            // 录制时失败、回放时成功：轨迹里没有对应的释放，立即归还，免得一直占着空间
+            unexpectedSuccesses.fetch_add(1, memory_order_relaxed);
+            manager.deallocate(move(block));
+            continue;
+        }
+        if (step.block != NO_BLOCK) {
+            blocks[step.block] = move(block);
+            ready[step.block].store(1, memory_order_release);
+        }
+    }
+}
+
+// 轨迹文件无法读取时返回 false
+bool runTraceReplay(const string& path, AllocatorBackend backend, bool threadCache, bool serial) {
+    ReplayTrace trace;
+    if (!loadReplayTrace(path, trace)) {
+        cerr << "无法读取轨迹文件: " << path << endl;
+        return false;
+    }
+    MemoryManager manager(SizeOfStack, backend, threadCache);
+    vector<unique_ptr<MemoryBlock>> blocks(trace.blockCount);
+    unique_ptr<atomic<uint8_t>[]> ready(new atomic<uint8_t>[trace.blockCount]());
+    atomic<long long> failures{0};
+    atomic<long long> unexpectedSuccesses{0};
+
+    auto startTime = chrono::steady_clock::now();
+    if (serial) {
+        replayThread(manager, trace.serial, blocks, ready.get(), failures, unexpectedSuccesses);
+    } else {
+        vector<thread> workers;
+        for (const auto& steps : trace.threads) {
+            workers.emplace_back(replayThread, ref(manager), cref(steps), ref(blocks), ready.get(),
+                                 ref(failures), ref(unexpectedSuccesses));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    size_t leftover = count_if(blocks.begin(), blocks.end(), [](const unique_ptr<MemoryBlock>& b) { return b != nullptr; });
+    AllocatorStats stats = manager.getStats();
+    for (auto& block : blocks) {
+        manager.deallocate(move(block));
+    }
+
+    cout << "回放: " << path << "，后端: " << backendName(backend) << (threadCache ? "（线程缓存）" : "")
+         << "，" << (serial ? "单线程按全局顺序" : to_string(trace.threads.size()) + " 个线程") << endl;
+    cout << "记录数: " << trace.serial.size() << "，耗时 " << seconds << " 秒，"
+         << static_cast<long long>(trace.serial.size() / max(seconds, 1e-9)) << " 次操作/秒" << endl;
+    cout << "申请失败: 录制时 " << trace.recordedFailures << " 次，回放时 " << failures.load()
+         << " 次；录制时失败而回放成功 " << unexpectedSuccesses.load() << " 次（已立即释放）" << endl;
+    if (trace.holdSamples > 0) {
+        cout << "录制时块的平均持有时间: " << trace.totalHoldNanos / trace.holdSamples / 1000 << " 微秒（"
+             << trace.holdSamples << " 个块）" << endl;
+    }
+    cout << "结束时未释放的块: " << leftover << endl;
+    printAllocatorStats(stats);
+    return true;
+}
+
+// 解析 --bench 之后的参数，出错时返回 false
+bool parseWorkloadConfig(int argc, char* argv[], int first, WorkloadConfig& config) {
+    for (int i = first; i < argc; i++) {
+        string option = argv[i];
+        if (i + 1 >= argc && option != "--no-cache") {
+            return false;
+        }
+        if (option == "--no-cache") {
+            config.threadCache = false;
+        } else if (option == "--threads") {
+            config.threads = max(1, atoi(argv[++i]));
+        } else if (option == "--ops") {
+            config.operationsPerThread = max(1LL, atoll(argv[++i]));
+        } else if (option == "--live") {
+            config.liveLimit = max(1, atoi(argv[++i]));
+        } else if (option == "--max-size") {
+            config.maxSize = max(1LL, min(MAX_BLOCK_SIZE, atoll(argv[++i])));
+        } else if (option == "--record") {
+            config.recordPath = argv[++i];
+        } else if (option == "--seed") {
+            config.seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+        } else if (option == "--backend") {
+            string name = argv[++i];
+            if (name == "extent") config.backend = AllocatorBackend::ExtentIndex;
+            else if (name == "buddy") config.backend = AllocatorBackend::Buddy;
+            else if (name == "lockfree") config.backend = AllocatorBackend::LockFreeBitmap;
+            else return false;
+        } else if (option == "--size-dist") {
+            string name = argv[++i];
+            if (name == "uniform") config.sizeDistribution = SizeDistribution::Uniform;
+            else if (name == "mix") config.sizeDistribution = SizeDistribution::Mix;
+            else if (name == "lognormal") config.sizeDistribution = SizeDistribution::LogNormal;
+            else if (name.rfind("trace:", 0) == 0) {
+                ifstream trace(name.substr(6));
+                long long size;
+                while (trace >> size) {
+                    if (size > 0 && size <= MAX_BLOCK_SIZE) config.traceSizes.push_back(size);
+                }
+                if (config.traceSizes.empty()) return false;
+                config.sizeDistribution = SizeDistribution::Trace;
+            } else return false;
+        } else if (option == "--hold-dist") {
+            string name = argv[++i];
+            size_t colon = name.find(':');
+            string kind = name.substr(0, colon);
+            if (colon != string::npos) config.meanHold = max(1.0, atof(name.c_str() + colon + 1));
+            if (kind == "fixed") config.holdDistribution = HoldDistribution::Fixed;
+            else if (kind == "uniform") config.holdDistribution = HoldDistribution::Uniform;
+            else if (kind == "exp") config.holdDistribution = HoldDistribution::Exponential;
+            else return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
 }
 
-int main() {
+void printUsage(const char* program) {
+    cout << "用法: " << program << " [--seed N]          运行演示，指定种子时各 CPU 的申请序列可重现" << endl;
+    cout << "      " << program << " --bench [选项]      可配置负载吞吐量测试" << endl;
+    cout << "  --threads N              线程数（默认 4）" << endl;
+    cout << "  --ops N                  每线程申请次数（默认 100000）" << endl;
+    cout << "  --size-dist 分布          uniform | mix | lognormal | trace:文件（默认 mix）" << endl;
+    cout << "  --max-size N             uniform/lognormal 的最大块大小（默认 1MB）" << endl;
+    cout << "  --hold-dist 分布[:均值]   fixed | uniform | exp，存活时长以操作数计（默认 exp:64）" << endl;
+    cout << "  --live N                 每线程最多同时持有的块数（默认 256）" << endl;
+    cout << "  --backend 后端            extent | buddy | lockfree（默认 extent）" << endl;
+    cout << "  --no-cache               关闭线程缓存" << endl;
+    cout << "  --seed N                 随机种子（默认 1）" << endl;
+    cout << "  --record 文件             把分配轨迹录制为二进制文件" << endl;
+    cout << "      " << program << " --replay 文件 [--backend 后端] [--no-cache] [--serial]" << endl;
+    cout << "                           回放轨迹；--serial 单线程按全局顺序，结果完全确定" << endl;
+    cout << "      " << program << " --bench-index | --compare-backends | --bench-contention | --bench-cache" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench-index") {
+        benchmarkExtentIndex();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--compare-backends") {
+        compareBackends();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-contention") {
+        benchmarkContention();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-cache") {
+        benchmarkThreadCache();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        WorkloadConfig config;
+        if (!parseWorkloadConfig(argc, argv, 2, config)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return runWorkloadBenchmark(config) ? 0 : 1;
+    }
+    if (argc > 2 && string(argv[1]) == "--replay") {
+        AllocatorBackend backend = AllocatorBackend::ExtentIndex;
+        bool threadCache = true;
+        bool serial = false;
+        for (int i = 3; i < argc; i++) {
+            string option = argv[i];
+            if (option == "--serial") {
+                serial = true;
+            } else if (option == "--no-cache") {
+                threadCache = false;
+            } else if (option == "--backend" && i + 1 < argc) {
+                string name = argv[++i];
+                if (name == "buddy") backend = AllocatorBackend::Buddy;
+                else if (name == "lockfree") backend = AllocatorBackend::LockFreeBitmap;
+                else if (name != "extent") { printUsage(argv[0]); return 1; }
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        return runTraceReplay(argv[2], backend, threadCache, serial) ? 0 : 1;
+    }
+    if (argc == 3 && string(argv[1]) == "--seed") {
+        ThreadSafeRandom::setSeed(strtoull(argv[2], nullptr, 10));
+    } else if (argc > 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
     try {
         // 固定CPU数量
         NumberOfCPU = 4;
@@ -209,6 +2221,10 @@ int main() {
         for (auto& thread : cpuThreads) {
             thread.join();
         }
+        long long droppedLogs = Logger::shutdown();
+        if (droppedLogs > 0) {
+            cout << "日志缓冲区满，丢弃 " << droppedLogs << " 条日志。" << endl;
+        }
         
         cout << "所有CPU工作完成。最终分配块数: " << memoryManager.getAllocatedBlockCount() << endl;
         
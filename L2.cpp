@@ -4,6 +4,8 @@
 
 OperatingSystem globalOS;
 
+static std::atomic<TaskHandle> nextTaskHandle{ 1 };
+
 bool MemoryManager::InitializeMemory() {
     int pageCount = GenerateThreadSafeRandom() %
         (MAX_PAGE_AMOUNT - MIN_PAGE_AMOUNT + 1) + MIN_PAGE_AMOUNT;
@@ -13,30 +15,141 @@ bool MemoryManager::InitializeMemory() {
     cout << "ҳ" << pageCount << " ҳԼ "
         << (float)pageCount * PAGE_BYTES / 1048576 << " MB" << endl;
 
-    for (int i = 0; i < pageCount; i++) {
-        MemoryPage page;
-        page.PageIndex = i;
-        MemoryPages.push_back(page);
-    }
-
-    message = "ڴʼɡ";
+    // ҳһη䵽λÿҳ 4 ֽ
+    auto initializeStart = std::chrono::steady_clock::now();
+    PageOwners.assign(pageCount, NO_TASK);
+    FreePages.Initialize(pageCount);
+    double elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - initializeStart).count();
+
+    char timing[96];
+    snprintf(timing, sizeof(timing), "ڴʼɣҳ %.1f MBʱ %.3f 롣",
+        (double)PageOwners.size() * sizeof(TaskHandle) / 1048576, elapsed);
+    message = timing;
     globalOS.DisplayMessage(message);
     return true;
 }
 
-bool MemoryManager::ValidateMemoryRange(long long StartAddr, long long Size) {
-    long long startPage = StartAddr / PAGE_BYTES;
-    long long endPage = (StartAddr + Size - 1) / PAGE_BYTES;
+void FreePageBitmap::Initialize(long long pageCount) {
+    size_t wordCount = (size_t)((pageCount + 63) / 64);
+    FreeWords.assign(wordCount, ~0ULL);
+    if (pageCount % 64 != 0) {
+        FreeWords[wordCount - 1] = (1ULL << (pageCount % 64)) - 1;   // ҳλԶ
+    }
+    AnyFreeSummary.assign((wordCount + 63) / 64, 0);
+    AllFreeSummary.assign((wordCount + 63) / 64, 0);
+    for (size_t i = 0; i < wordCount; i++) {
+        RefreshSummary(i);
+    }
+}
 
-    for (long long i = startPage; i <= endPage; i++) {
-        if (MemoryPages[i].AssignedTask != nullptr) {
-            return false;
+void FreePageBitmap::RefreshSummary(size_t word) {
+    uint64_t bit = 1ULL << (word % 64);
+    if (FreeWords[word] != 0) AnyFreeSummary[word / 64] |= bit;
+    else AnyFreeSummary[word / 64] &= ~bit;
+    if (FreeWords[word] == ~0ULL) AllFreeSummary[word / 64] |= bit;
+    else AllFreeSummary[word / 64] &= ~bit;
+}
+
+// λ [firstPage, firstPage + pageCount) Ӧλ
+static void UpdatePageBits(FreePageBitmap& bitmap, long long firstPage, long long pageCount, bool free) {
+    long long page = firstPage;
+    long long end = firstPage + pageCount;
+    while (page < end) {
+        size_t word = (size_t)(page / 64);
+        int offset = (int)(page % 64);
+        long long bits = std::min<long long>(64 - offset, end - page);
+        uint64_t mask = (bits == 64 ? ~0ULL : ((1ULL << bits) - 1)) << offset;
+        if (free) bitmap.FreeWords[word] |= mask;
+        else bitmap.FreeWords[word] &= ~mask;
+        bitmap.RefreshSummary(word);
+        page += bits;
+    }
+}
+
+void FreePageBitmap::MarkUsed(long long firstPage, long long pageCount) {
+    UpdatePageBits(*this, firstPage, pageCount, false);
+}
+
+void FreePageBitmap::MarkFree(long long firstPage, long long pageCount) {
+    UpdatePageBits(*this, firstPage, pageCount, true);
+}
+
+//  stridePages ҲС firstPage λϲ pageCount ҳ
+// Ҳ -1÷֤ pageCount <= stridePages  stridePages  2 ݣ
+//  stridePages <= 64 ʱѡ䲻֣ʱѡǴֵı߽翪ʼ
+long long FreePageBitmap::FindFreeRun(long long pageCount, long long stridePages, long long firstPage) const {
+    size_t wordCount = FreeWords.size();
+
+    if (stridePages <= 64) {
+        // ÿ
+        uint64_t strideMask = 0;
+        for (long long bit = 0; bit < 64; bit += stridePages) {
+            strideMask |= 1ULL << bit;
         }
+        size_t word = (size_t)(firstPage / 64);
+        uint64_t skipMask = ~0ULL << (firstPage % 64);
+        while (word < wordCount) {
+            // ժҪûпҳ
+            uint64_t summary = AnyFreeSummary[word / 64] & (~0ULL << (word % 64));
+            if (summary == 0) {
+                word = (word / 64 + 1) * 64;
+                skipMask = ~0ULL;
+                continue;
+            }
+            size_t next = (word / 64) * 64 + __builtin_ctzll(summary);
+            if (next != word) {
+                word = next;
+                skipMask = ~0ULL;
+            }
+            if (word >= wordCount) break;
+
+            // ȲС pageCount λ
+            uint64_t runs = FreeWords[word];
+            long long length = 1;
+            while (length < pageCount && runs != 0) {
+                long long shift = std::min(length, pageCount - length);
+                runs &= runs >> shift;
+                length += shift;
+            }
+            runs &= strideMask & skipMask;
+            if (runs != 0) {
+                return (long long)word * 64 + __builtin_ctzll(runs);
+            }
+            word++;
+            skipMask = ~0ULL;
+        }
+        return -1;
     }
-    return true;
+
+    // 飺ǰ pageCount / 64 ֱȫУʣҳһֵĵλ
+    size_t strideWords = (size_t)(stridePages / 64);
+    size_t fullWords = (size_t)(pageCount / 64);
+    uint64_t tailMask = (1ULL << (pageCount % 64)) - 1;
+    size_t candidate = (size_t)((firstPage + stridePages - 1) / stridePages) * strideWords;
+    while (candidate + fullWords <= wordCount) {
+        size_t checked = 0;
+        while (checked < fullWords &&
+            (AllFreeSummary[(candidate + checked) / 64] >> ((candidate + checked) % 64)) & 1) {
+            checked++;
+        }
+        if (checked == fullWords) {
+            if (tailMask == 0) {
+                return (long long)candidate * 64;
+            }
+            if (candidate + fullWords < wordCount &&
+                (FreeWords[candidate + fullWords] & tailMask) == tailMask) {
+                return (long long)candidate * 64;
+            }
+        }
+        // Խһ֮һѡλ
+        size_t blocking = candidate + checked;
+        candidate = (blocking / strideWords + 1) * strideWords;
+    }
+    return -1;
 }
 
-ProcessTask::ProcessTask(string id) : TaskIdentifier(id) {
+ProcessTask::ProcessTask(string id) : TaskIdentifier(id), Handle(nextTaskHandle++) {
     int randomType = GenerateThreadSafeRandom() % 100 + 1;
 
     if (randomType <= 60) {
@@ -58,11 +171,88 @@ bool ProcessTask::operator<(const ProcessTask& other) const {
     return RemainingDuration > other.RemainingDuration;
 }
 
+void TaskReadyQueue::Build(const vector<ProcessTask>& tasks) {
+    Heap.resize(tasks.size());
+    Position.resize(tasks.size());
+    for (size_t i = 0; i < tasks.size(); i++) {
+        Heap[i] = (int)i;
+        Position[i] = (int)i;
+    }
+    for (size_t i = Heap.size() / ARITY + 1; i-- > 0;) {
+        SiftDown(tasks, i);
+    }
+}
+
+bool TaskReadyQueue::Empty() const {
+    return Heap.empty();
+}
+
+int TaskReadyQueue::Top() const {
+    return Heap.front();
+}
+
+bool TaskReadyQueue::Before(const vector<ProcessTask>& tasks, int first, int second) const {
+    if (tasks[first].RemainingDuration != tasks[second].RemainingDuration) {
+        return tasks[first].RemainingDuration < tasks[second].RemainingDuration;
+    }
+    return first < second;
+}
+
+void TaskReadyQueue::SiftUp(const vector<ProcessTask>& tasks, size_t position) {
+    int task = Heap[position];
+    while (position > 0) {
+        size_t parent = (position - 1) / ARITY;
+        if (!Before(tasks, task, Heap[parent])) break;
+        Heap[position] = Heap[parent];
+        Position[Heap[position]] = (int)position;
+        position = parent;
+    }
+    Heap[position] = task;
+    Position[task] = (int)position;
+}
+
+void TaskReadyQueue::SiftDown(const vector<ProcessTask>& tasks, size_t position) {
+    if (position >= Heap.size()) return;
+    int task = Heap[position];
+    while (true) {
+        size_t firstChild = position * ARITY + 1;
+        if (firstChild >= Heap.size()) break;
+        size_t best = firstChild;
+        size_t lastChild = std::min(firstChild + ARITY, Heap.size());
+        for (size_t child = firstChild + 1; child < lastChild; child++) {
+            if (Before(tasks, Heap[child], Heap[best])) best = child;
+        }
+        if (!Before(tasks, Heap[best], task)) break;
+        Heap[position] = Heap[best];
+        Position[Heap[position]] = (int)position;
+        position = best;
+    }
+    Heap[position] = task;
+    Position[task] = (int)position;
+}
+
+void TaskReadyQueue::Remove(const vector<ProcessTask>& tasks, int taskIndex) {
+    size_t position = (size_t)Position[taskIndex];
+    Position[taskIndex] = -1;
+    int last = Heap.back();
+    Heap.pop_back();
+    if (last == taskIndex) return;
+    Heap[position] = last;
+    Position[last] = (int)position;
+    SiftUp(tasks, position);
+    SiftDown(tasks, (size_t)Position[last]);
+}
+
+void TaskReadyQueue::DecreaseKey(const vector<ProcessTask>& tasks, int taskIndex) {
+    SiftUp(tasks, (size_t)Position[taskIndex]);
+}
+
 bool ProcessorUnit::InitializeProcessor() {
     string message = " " + std::to_string(ProcessorID) + " ʼʼ";
     globalOS.DisplayMessage(message);
 
-    for (int i = 0; i < TASKS_PER_PROCESSOR; i++) {
+    TaskCollection.reserve(globalOS.TasksPerProcessor);
+    for (int i = 0; i < globalOS.TasksPerProcessor; i++) {
         string taskInfo = "[ " + std::to_string(ProcessorID) +
             "  " + std::to_string(i) + " ]";
         ProcessTask task(taskInfo);
@@ -129,98 +319,151 @@ bool OperatingSystem::AllocateMemory(ProcessorUnit& cpu) {
         alignment *= 2;
     }
 
-    for (long long start = alignment; start <= (long long)PAGE_BYTES *
-        (long long)SystemMemory.MemoryPages.size() - size; start += alignment) {
-
-        if (SystemMemory.ValidateMemoryRange(start, size)) {
-            long long startPage = start / PAGE_BYTES;
-            long long endPage = (start + size - 1) / PAGE_BYTES;
+    // ʼַ alignment ҲΪ 00 ʾδ䣩벻һҳʱͬһҳڵĶ
+    // ҳ 0 ҳӵַ alignment ʼãһҳʱҳŰ alignment / PAGE_BYTES 룬 0 ҳ
+    long long pageCount = (size + PAGE_BYTES - 1) / PAGE_BYTES;
+    long long stridePages = std::max(1LL, alignment / PAGE_BYTES);
+    long long firstPage = alignment < PAGE_BYTES ? 0 : stridePages;
 
-            for (long long i = startPage; i <= endPage; i++) {
-                SystemMemory.MemoryPages[i].AssignedTask =
-                    &cpu.TaskCollection[cpu.CurrentTaskIndex];
-            }
+    long long startPage = SystemMemory.FreePages.FindFreeRun(pageCount, stridePages, firstPage);
+    if (startPage < 0) {
+        return false;
+    }
+    long long start = startPage == 0 ? alignment : startPage * PAGE_BYTES;
+    long long endPage = (start + size - 1) / PAGE_BYTES;
 
-            cpu.TaskCollection[cpu.CurrentTaskIndex].AllocationStart = start;
-            return true;
-        }
+    for (long long i = startPage; i <= endPage; i++) {
+        SystemMemory.PageOwners[i] = cpu.TaskCollection[cpu.CurrentTaskIndex].Handle;
     }
-    return false;
+    SystemMemory.FreePages.MarkUsed(startPage, endPage - startPage + 1);
+
+    cpu.TaskCollection[cpu.CurrentTaskIndex].AllocationStart = start;
+    cpu.TaskCollection[cpu.CurrentTaskIndex].AllocatedFirstPage = startPage;
+    cpu.TaskCollection[cpu.CurrentTaskIndex].AllocatedPageCount = endPage - startPage + 1;
+    return true;
 }
 
 bool OperatingSystem::ReleaseMemory(ProcessorUnit& cpu) {
     lock_guard<mutex> lock(SystemMemory.MemoryAccessLock);
+    ProcessTask& task = cpu.TaskCollection[cpu.CurrentTaskIndex];
 
-    for (auto& page : SystemMemory.MemoryPages) {
-        if (page.AssignedTask == &cpu.TaskCollection[cpu.CurrentTaskIndex]) {
-            page.AssignedTask = nullptr;
-        }
+    // ֻʷʱ¼ҳɨҳ
+    long long endPage = task.AllocatedFirstPage + task.AllocatedPageCount;
+    for (long long i = task.AllocatedFirstPage; i < endPage; i++) {
+        SystemMemory.PageOwners[i] = NO_TASK;
     }
+    if (task.AllocatedPageCount > 0) {
+        SystemMemory.FreePages.MarkFree(task.AllocatedFirstPage, task.AllocatedPageCount);
+    }
+    ReleaseCount++;
+    ReleasePagesTouched += task.AllocatedPageCount;
 
-    cpu.TaskCollection[cpu.CurrentTaskIndex].AllocationStart = 0;
+    task.AllocationStart = 0;
+    task.AllocatedFirstPage = 0;
+    task.AllocatedPageCount = 0;
     return true;
 }
 
+void OperatingSystem::DisplayReleaseStatistics() {
+    long long releases;
+    long long pagesTouched;
+    {
+        lock_guard<mutex> lock(SystemMemory.MemoryAccessLock);
+        releases = ReleaseCount;
+        pagesTouched = ReleasePagesTouched;
+    }
+    char average[32];
+    snprintf(average, sizeof(average), "%.2f", releases == 0 ? 0.0 : (double)pagesTouched / releases);
+    string message = "ڴͷ " + std::to_string(releases) + " Σ " +
+        std::to_string(pagesTouched) + " ҳƽÿ " + average + " ҳҳ " +
+        std::to_string(SystemMemory.PageOwners.size()) + " ҳ";
+    lock_guard<mutex> lock(OutputLock);
+    cout << message << endl;
+}
+
 void OperatingSystem::DisplayMessage(string& text) {
+    if (QuietMode) {
+        return;
+    }
     OutputLock.lock();
+    if (VirtualClock >= 0) {
+        cout << "[" << VirtualClock << "] ";
+    }
     cout << text << endl;
     OutputLock.unlock();
 }
 
-void ProcessorUnit::ExecuteTasks() {
-    string message = " " + std::to_string(ProcessorID) + " ʼִ";
+// ¼ʵʱģʽʱģʽã֤ģʽĵһ
+
+bool ProcessorUnit::StartSelectedTask() {
+    string message = " " + std::to_string(ProcessorID) +
+        " ѡ" + TaskCollection[CurrentTaskIndex].TaskIdentifier +
+        " ʣʱ䣺" + std::to_string(TaskCollection[CurrentTaskIndex].RemainingDuration) + " 룩";
     globalOS.DisplayMessage(message);
 
-    while (!TaskCollection.empty()) {
-        auto shortestTask = min_element(TaskCollection.begin(), TaskCollection.end(),
-            [](const ProcessTask& a, const ProcessTask& b) {
-                return a.RemainingDuration < b.RemainingDuration;
-            });
+    if (TaskCollection[CurrentTaskIndex].AllocationStart == 0) {
+        if (!globalOS.AllocateMemory(*this)) {
+            message = " " + std::to_string(ProcessorID) +
+                " ڴʧܣ" + TaskCollection[CurrentTaskIndex].TaskIdentifier;
+            globalOS.DisplayMessage(message);
+            ReadyTasks.Remove(TaskCollection, CurrentTaskIndex);
+            return false;
+        }
+        message = " " + std::to_string(ProcessorID) +
+            " ڴʼַ" + std::to_string(TaskCollection[CurrentTaskIndex].AllocationStart) +
+            " (С:" + std::to_string(TaskCollection[CurrentTaskIndex].MemoryRequirement) + " ֽ)";
+        globalOS.DisplayMessage(message);
+    }
+    return true;
+}
 
-        CurrentTaskIndex = distance(TaskCollection.begin(), shortestTask);
+bool ProcessorUnit::TickCurrentTask() {
+    TaskCollection[CurrentTaskIndex].RemainingDuration--;
+    ReadyTasks.DecreaseKey(TaskCollection, CurrentTaskIndex);
+    return GenerateThreadSafeRandom() % 10 < 3;
+}
 
-        message = " " + std::to_string(ProcessorID) +
-            " ѡ" + TaskCollection[CurrentTaskIndex].TaskIdentifier +
-            " ʣʱ䣺" + std::to_string(TaskCollection[CurrentTaskIndex].RemainingDuration) + " 룩";
+void ProcessorUnit::InterruptCurrentTask() {
+    globalOS.HandleInterrupt(*this);
+
+    if (TaskCollection[CurrentTaskIndex].RemainingDuration > 0) {
+        string message = " " + std::to_string(ProcessorID) +
+            " жϱ: " + TaskCollection[CurrentTaskIndex].TaskIdentifier +
+            " (ʣ:" + std::to_string(TaskCollection[CurrentTaskIndex].RemainingDuration) + ")";
         globalOS.DisplayMessage(message);
+    }
+}
 
-        if (TaskCollection[CurrentTaskIndex].AllocationStart == 0) {
-            if (!globalOS.AllocateMemory(*this)) {
-                message = " " + std::to_string(ProcessorID) +
-                    " ڴʧܣ" + TaskCollection[CurrentTaskIndex].TaskIdentifier;
-                globalOS.DisplayMessage(message);
-                TaskCollection.erase(TaskCollection.begin() + CurrentTaskIndex);
-                continue;
-            }
-            message = " " + std::to_string(ProcessorID) +
-                " ڴʼַ" + std::to_string(TaskCollection[CurrentTaskIndex].AllocationStart) +
-                " (С:" + std::to_string(TaskCollection[CurrentTaskIndex].MemoryRequirement) + " ֽ)";
-            globalOS.DisplayMessage(message);
+void ProcessorUnit::CompleteCurrentTask() {
+    string message = " " + std::to_string(ProcessorID) +
+        " : " + TaskCollection[CurrentTaskIndex].TaskIdentifier;
+    globalOS.DisplayMessage(message);
+    globalOS.ReleaseMemory(*this);
+    ReadyTasks.Remove(TaskCollection, CurrentTaskIndex);
+}
+
+void ProcessorUnit::ExecuteTasks() {
+    string message = " " + std::to_string(ProcessorID) + " ʼִ";
+    globalOS.DisplayMessage(message);
+
+    // ʣʱȣÿδӾȡʣʱ̵
+    ReadyTasks.Build(TaskCollection);
+    while (!ReadyTasks.Empty()) {
+        CurrentTaskIndex = ReadyTasks.Top();
+        if (!StartSelectedTask()) {
+            continue;
         }
 
         while (TaskCollection[CurrentTaskIndex].RemainingDuration > 0) {
             sleep_for(seconds(1));
-            TaskCollection[CurrentTaskIndex].RemainingDuration--;
-
-            if (GenerateThreadSafeRandom() % 10 < 3) {
-                globalOS.HandleInterrupt(*this);
-
-                if (TaskCollection[CurrentTaskIndex].RemainingDuration > 0) {
-                    message = " " + std::to_string(ProcessorID) +
-                        " жϱ: " + TaskCollection[CurrentTaskIndex].TaskIdentifier +
-                        " (ʣ:" + std::to_string(TaskCollection[CurrentTaskIndex].RemainingDuration) + ")";
-                    globalOS.DisplayMessage(message);
-                }
+            if (TickCurrentTask()) {
+                InterruptCurrentTask();
                 break;
             }
         }
 
         if (TaskCollection[CurrentTaskIndex].RemainingDuration == 0) {
-            message = " " + std::to_string(ProcessorID) +
-                " : " + TaskCollection[CurrentTaskIndex].TaskIdentifier;
-            globalOS.DisplayMessage(message);
-            globalOS.ReleaseMemory(*this);
-            TaskCollection.erase(TaskCollection.begin() + CurrentTaskIndex);
+            CompleteCurrentTask();
         }
     }
 
@@ -228,14 +471,141 @@ void ProcessorUnit::ExecuteTasks() {
     globalOS.DisplayMessage(message);
 }
 
+bool SimulationEvent::operator>(const SimulationEvent& other) const {
+    if (Time != other.Time) {
+        return Time > other.Time;
+    }
+    return Sequence > other.Sequence;
+}
+
+// ʱģʽдһ߳ﰴ¼ʱƽÿʱһ¼
+// ȴͬһʱ̵¼Ⱥ
+void OperatingSystem::RunVirtualTime() {
+    std::priority_queue<SimulationEvent, vector<SimulationEvent>, std::greater<SimulationEvent>> events;
+    long long sequence = 0;
+    long long processedEvents = 0;
+    long long tickCount = 0;
+    auto schedule = [&](long long time, int processor, SimulationEventType type) {
+        events.push(SimulationEvent{ time, sequence++, processor, type });
+    };
+
+    auto wallStart = std::chrono::steady_clock::now();
+    VirtualClock = 0;
+    for (auto& processor : Processors) {
+        string message = " " + std::to_string(processor.ProcessorID) + " ʼִ";
+        DisplayMessage(message);
+        processor.ReadyTasks.Build(processor.TaskCollection);
+        schedule(0, processor.ProcessorID, SimulationEventType::Dispatch);
+    }
+
+    while (!events.empty()) {
+        SimulationEvent event = events.top();
+        events.pop();
+        processedEvents++;
+        VirtualClock = event.Time;
+        ProcessorUnit& cpu = Processors[event.ProcessorID];
+        ProcessTask* task = cpu.ReadyTasks.Empty() ? nullptr : &cpu.TaskCollection[cpu.CurrentTaskIndex];
+
+        switch (event.Type) {
+        case SimulationEventType::Dispatch:
+            if (cpu.ReadyTasks.Empty()) {
+                string message = " " + std::to_string(cpu.ProcessorID) + " ִн";
+                DisplayMessage(message);
+                break;
+            }
+            cpu.CurrentTaskIndex = cpu.ReadyTasks.Top();
+            if (cpu.StartSelectedTask()) {
+                schedule(event.Time + 1, cpu.ProcessorID, SimulationEventType::Tick);
+            }
+            else {
+                schedule(event.Time, cpu.ProcessorID, SimulationEventType::Dispatch);
+            }
+            break;
+        case SimulationEventType::Tick:
+            tickCount++;
+            if (cpu.TickCurrentTask()) {
+                schedule(event.Time, cpu.ProcessorID, SimulationEventType::Interrupt);
+            }
+            else if (task->RemainingDuration == 0) {
+                schedule(event.Time, cpu.ProcessorID, SimulationEventType::Completion);
+            }
+            else {
+                schedule(event.Time + 1, cpu.ProcessorID, SimulationEventType::Tick);
+            }
+            break;
+        case SimulationEventType::Interrupt:
+            cpu.InterruptCurrentTask();
+            schedule(event.Time, cpu.ProcessorID, task->RemainingDuration == 0 ?
+                SimulationEventType::Completion : SimulationEventType::Dispatch);
+            break;
+        case SimulationEventType::Completion:
+            cpu.CompleteCurrentTask();
+            schedule(event.Time, cpu.ProcessorID, SimulationEventType::Dispatch);
+            break;
+        }
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    char summary[160];
+    snprintf(summary, sizeof(summary), "ʱģʽģ %lld 룬%lld ʱڣ%lld ¼ʵʺʱ %.3f 롣",
+        VirtualClock, tickCount, processedEvents, wallSeconds);
+    lock_guard<mutex> lock(OutputLock);
+    cout << summary << endl;
+}
+
+static bool randomSeedSet = false;
+static unsigned randomSeed = 0;
+static std::atomic<unsigned> nextRandomStream{ 0 };
+
+void SetRandomSeed(unsigned seed) {
+    randomSeed = seed;
+    randomSeedSet = true;
+}
+
+// ָʱÿ̰߳״ʹõȺȡͬУʱģʽֻһ̣߳п
+static std::mt19937 CreateThreadGenerator() {
+    if (!randomSeedSet) {
+        return std::mt19937(std::random_device{}());
+    }
+    std::seed_seq sequence{ randomSeed, nextRandomStream++ };
+    return std::mt19937(sequence);
+}
+
 int GenerateThreadSafeRandom() {
-    thread_local std::mt19937 generator(std::random_device{}());
+    thread_local std::mt19937 generator = CreateThreadGenerator();
     std::uniform_int_distribution<int> distribution(0, 2147483647);
     return distribution(generator);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--tasks" && i + 1 < argc) {
+            globalOS.TasksPerProcessor = std::max(1, atoi(argv[++i]));
+        }
+        else if (option == "--seed" && i + 1 < argc) {
+            SetRandomSeed((unsigned)strtoul(argv[++i], nullptr, 10));
+        }
+        else if (option == "--virtual") {
+            globalOS.VirtualTimeMode = true;
+        }
+        else if (option == "--quiet") {
+            globalOS.QuietMode = true;
+        }
+        else {
+            cout << "÷" << argv[0] << " [--tasks ÿ] [--seed ] [--virtual] [--quiet]" << endl;
+            cout << "  --virtual  ʱɢ¼ģʽȴ" << endl;
+            cout << "  --quiet    Ϣֻͳ" << endl;
+            return 1;
+        }
+    }
     globalOS.SystemInitialize();
-    globalOS.StartSystem();
+    if (globalOS.VirtualTimeMode) {
+        globalOS.RunVirtualTime();
+    }
+    else {
+        globalOS.StartSystem();
+    }
+    globalOS.DisplayReleaseStatistics();
     return 0;
 }
\ No newline at end of file
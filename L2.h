@@ -9,6 +9,11 @@
 #include <string>
 #include <chrono>
 #include <algorithm>
+#include <atomic>
+#include <queue>
+#include <functional>
+#include <cstdint>
+#include <cstdio>
 
 using std::cout;
 using std::endl;
@@ -17,7 +22,6 @@ using std::vector;
 using std::thread;
 using std::mutex;
 using std::lock_guard;
-using std::min_element;
 using std::this_thread::sleep_for;
 using std::chrono::seconds;
 
@@ -29,7 +33,6 @@ constexpr int TASKS_PER_PROCESSOR = 5;      // ÿ
 constexpr int PAGE_BYTES = 4096;            // ҳֽ
 
 // ǰ
-struct MemoryPage;
 struct MemoryManager;
 struct ProcessTask;
 struct ProcessorUnit;
@@ -37,47 +40,105 @@ struct OperatingSystem;
 
 // ̰߳ȫ
 int GenerateThreadSafeRandom();
+void SetRandomSeed(unsigned seed);          // ָӣʹп
 
-// ڴҳṹ
-struct MemoryPage
+// ҳֻ 32 λ0 ʾҳ
+using TaskHandle = uint32_t;
+constexpr TaskHandle NO_TASK = 0;
+
+// ҳλͼÿ 64 λּ¼ 64 ҳλʾУ
+// ϲժҪÿһλӦһֱ֣Ǹ֡пҳ͡ȫС
+struct FreePageBitmap
 {
-    int PageIndex = 0;                      // ҳ
-    const int PageCapacity = PAGE_BYTES;    // ҳС
-    ProcessTask* AssignedTask = nullptr;    // ռøҳָ
+    vector<uint64_t> FreeWords;             //  0 㣺ÿҳһλ
+    vector<uint64_t> AnyFreeSummary;        // ժҪӦַ
+    vector<uint64_t> AllFreeSummary;        // ժҪӦȫΪ 1
+
+    void Initialize(long long pageCount);   // ȫҳΪ
+    void MarkUsed(long long firstPage, long long pageCount); // һҳռ
+    void MarkFree(long long firstPage, long long pageCount); // һҳѿ
+    long long FindFreeRun(long long pageCount, long long stridePages, long long firstPage) const; // ҳ
+    void RefreshSummary(size_t word);       // ĳֱ仯ժҪ
 };
 
 // ڴ
 struct MemoryManager
 {
-    vector<MemoryPage> MemoryPages;         // ڴҳ
+    vector<TaskHandle> PageOwners;          // ҳ±꼴ҳţÿҳ̶Ϊ PAGE_BYTESֵΪռ
+    FreePageBitmap FreePages;               // ҳλͼ
     mutex MemoryAccessLock;                 // ڴʻ
 
     bool InitializeMemory();                // ڴʼ
-    bool ValidateMemoryRange(long long StartAddr, long long Size); // ڴ֤
 };
 
 // ṹ
 struct ProcessTask
 {
     string TaskIdentifier;                  // ʶ
+    TaskHandle Handle = NO_TASK;            // ʱ䣬ȫΨһ
     int ExecutionDuration = 0;              // ִʱ
     int RemainingDuration = 0;              // ʣִʱ
     long long MemoryRequirement = 0;        // ڴС
     long long AllocationStart = 0;          // ڴʼַ
+    long long AllocatedFirstPage = 0;       // ѷҳҳ
+    long long AllocatedPageCount = 0;       // ѷҳ0 ʾδ
 
     explicit ProcessTask(string id);        // ʽ캯
     bool operator<(const ProcessTask& other) const; // Ƚ
 };
 
+// У±ΪԪصĲѣʣʱͬʱ±Сȣ
+// ¼ÿڶеλãʣʱʱԭϸȡɾ O(log n)
+struct TaskReadyQueue
+{
+    static constexpr int ARITY = 4;         // ÿڵӽڵ
+    vector<int> Heap;                       // е±
+    vector<int> Position;                   // ± -> λã-1 ʾڶ
+
+    void Build(const vector<ProcessTask>& tasks);   // ȫ
+    bool Empty() const;                     // ǷΪ
+    int Top() const;                        // ʣʱ̵±
+    void Remove(const vector<ProcessTask>& tasks, int taskIndex);      // Ƴ
+    void DecreaseKey(const vector<ProcessTask>& tasks, int taskIndex); // ʣʱٺλ
+    bool Before(const vector<ProcessTask>& tasks, int first, int second) const; // 
+    void SiftUp(const vector<ProcessTask>& tasks, size_t position);   // ϸ
+    void SiftDown(const vector<ProcessTask>& tasks, size_t position); // ³
+};
+
 // Ԫ
 struct ProcessorUnit
 {
     int ProcessorID = 0;                    // ʶ
-    vector<ProcessTask> TaskCollection;     // 񼯺
+    vector<ProcessTask> TaskCollection;     // 񼯺ϣִڼ䲻ɾ±꼴ȶ
+    TaskReadyQueue ReadyTasks;              // δɵ
     int CurrentTaskIndex = 0;               // ǰִ
 
     bool InitializeProcessor();             // ʼ
-    void ExecuteTasks();                    // ִз
+    void ExecuteTasks();                    // ִзʵʱģʽ
+    bool StartSelectedTask();               // ʼִѡеڴʧʱƳв false
+    bool TickCurrentTask();                 // ǰִһʱڣǷж
+    void InterruptCurrentTask();            // ǰж
+    void CompleteCurrentTask();             // ǰɣͷڴ沢Ƴ
+};
+
+// ʱģʽ¼
+enum class SimulationEventType
+{
+    Dispatch,                               // ѡһ
+    Tick,                                   // ǰִһʱ
+    Interrupt,                              // ǰж
+    Completion                              // ǰ
+};
+
+// ʱģʽ¼
+struct SimulationEvent
+{
+    long long Time = 0;                     // ʱ䣨룩
+    long long Sequence = 0;                 // ˳ͬһʱȲȴ
+    int ProcessorID = 0;                    // 
+    SimulationEventType Type = SimulationEventType::Dispatch; // ¼
+
+    bool operator>(const SimulationEvent& other) const; // ȶбȽ
 };
 
 // ϵͳ
@@ -86,13 +147,21 @@ struct OperatingSystem
     vector<ProcessorUnit> Processors;       // 
     MemoryManager SystemMemory;             // ϵͳڴ
     mutex OutputLock;                       // ͬ
+    long long ReleaseCount = 0;             // ڴͷŴڴ
+    long long ReleasePagesTouched = 0;      // ͷʱʹҳۼ
+    int TasksPerProcessor = TASKS_PER_PROCESSOR; // ÿָ
+    bool VirtualTimeMode = false;           // Ƿʹʱɢ¼ģʽ
+    bool QuietMode = false;                 // ǷʡϢ
+    long long VirtualClock = -1;            // ʱӣ룩ʵʱģʽΪ -1
 
     bool SystemInitialize();                // ϵͳʼ
-    void StartSystem();                     // ϵͳ
+    void StartSystem();                     // ϵͳУʵʱģʽ
+    void RunVirtualTime();                  // ʱȫ
     void HandleInterrupt(ProcessorUnit& cpu); // жϴ
     bool AllocateMemory(ProcessorUnit& cpu); // ڴ
     bool ReleaseMemory(ProcessorUnit& cpu);  // ڴͷ
     void DisplayMessage(string& text);      // Ϣʾ
+    void DisplayReleaseStatistics();        // ʾڴͷͳ
 };
 
 extern OperatingSystem globalOS;            // ȫֲϵͳʵ